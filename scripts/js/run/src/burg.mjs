@@ -2,7 +2,6 @@ import { exec } from './exec.mjs';
 
 import { Option, program } from 'commander';
 import { mkdir } from 'node:fs/promises';
-import { openSync } from 'node:fs';
 import { join } from 'node:path';
 import { createCommand } from './command.mjs';
 
@@ -23,96 +22,45 @@ burgCommand.action(async (options) => {
   if (output) await mkdir(output, { recursive: true });
   else output = '.';
 
-  const DATA_TYPE =
-    dataType == 'D' ? 'DOUBLE' : dataType == 'LD' ? 'LONG_DOUBLE' : 'DOUBLE';
+  const TYPE = dataType == 'LD' ? 'long_double' : 'double';
 
+  const estimators = [
+    'burg_basic',
+    'burg_optimized_den',
+    'burg_optimized_den_sqrt',
+  ];
+  const compensated_estimators = [
+    'compensated_burg_basic',
+    'compensated_burg_optimized_den',
+    'compensated_burg_optimized_den_sqrt',
+  ];
+
+  // Every engine is built into a single binary and selected at runtime,
+  // so each build is configured, compiled and run only once
   const commands = [
     // No flags
     {
-      cmd_name: 'burg-basic',
+      cmd_name: '',
       compile: [
-        `cmake -B tmp_build -DCMAKE_BUILD_TYPE=Release -DBURG=BASIC -DDATA_TYPE=${DATA_TYPE}`,
+        'cmake -B tmp_build -DCMAKE_BUILD_TYPE=Release',
         'cmake --build tmp_build --target burg -j 4',
       ],
-      run: './tmp_build/burg',
-      clean: 'rm -r tmp_build',
-    },
-    {
-      cmd_name: 'burg-optimized-den',
-      compile: [
-        `cmake -B tmp_build -DCMAKE_BUILD_TYPE=Release -DBURG=OPT_DEN -DDATA_TYPE=${DATA_TYPE}`,
-        'cmake --build tmp_build --target burg -j 4',
-      ],
-      run: './tmp_build/burg',
-      clean: 'rm -r tmp_build',
-    },
-    {
-      cmd_name: 'burg-optimized-den-sqrt',
-      compile: [
-        `cmake -B tmp_build -DCMAKE_BUILD_TYPE=Release -DBURG=OPT_DEN_SQRT -DDATA_TYPE=${DATA_TYPE}`,
-        'cmake --build tmp_build --target burg -j 4',
+      engines: [
+        ...estimators,
+        // Error compensation is no needed for long doubles
+        ...(TYPE === 'double' ? compensated_estimators : []),
       ],
-      run: './tmp_build/burg',
       clean: 'rm -r tmp_build',
     },
-    ...(DATA_TYPE === 'DOUBLE'
-      ? [
-          {
-            cmd_name: 'compensated-burg-basic',
-            compile: [
-              `cmake -B tmp_build -DCMAKE_BUILD_TYPE=Release -DBURG=COMP_BASIC -DDATA_TYPE=${DATA_TYPE}`,
-              'cmake --build tmp_build --target burg -j 4',
-            ],
-            run: './tmp_build/burg',
-            clean: 'rm -r tmp_build',
-          },
-          {
-            cmd_name: 'compensated-burg-optimized-den',
-            compile: [
-              `cmake -B tmp_build -DCMAKE_BUILD_TYPE=Release -DBURG=COMP_OPT_DEN -DDATA_TYPE=${DATA_TYPE}`,
-              'cmake --build tmp_build --target burg -j 4',
-            ],
-            run: './tmp_build/burg',
-            clean: 'rm -r tmp_build',
-          },
-          {
-            cmd_name: 'compensated-burg-optimized-den-sqrt',
-            compile: [
-              `cmake -B tmp_build -DCMAKE_BUILD_TYPE=Release -DBURG=COMP_OPT_DEN_SQRT -DDATA_TYPE=${DATA_TYPE}`,
-              'cmake --build tmp_build --target burg -j 4',
-            ],
-            run: './tmp_build/burg',
-            clean: 'rm -r tmp_build',
-          },
-        ]
-      : []), // Error compensation is no needed for long doubles 
 
     // Fast math
     {
-      cmd_name: 'burg-basic-fast_math',
-      compile: [
-        `cmake -B tmp_build -DCMAKE_BUILD_TYPE=Release -DFAST_MATH=ON -DBURG=BASIC -DDATA_TYPE=${DATA_TYPE}`,
-        'cmake --build tmp_build --target burg -j 4',
-      ],
-      run: './tmp_build/burg',
-      clean: 'rm -r tmp_build',
-    },
-    {
-      cmd_name: 'burg-optimized-den-fast_math',
-      compile: [
-        `cmake -B tmp_build -DCMAKE_BUILD_TYPE=Release -DFAST_MATH=ON -DBURG=OPT_DEN -DDATA_TYPE=${DATA_TYPE}`,
-        'cmake --build tmp_build --target burg -j 4',
-      ],
-      run: './tmp_build/burg',
-      clean: 'rm -r tmp_build',
-    },
-    {
-      cmd_name: 'burg-optimized-den-sqrt-fast_math',
+      cmd_name: 'fast_math',
       compile: [
-        `cmake -B tmp_build -DCMAKE_BUILD_TYPE=Release -DFAST_MATH=ON -DBURG=OPT_DEN_SQRT -DDATA_TYPE=${DATA_TYPE}`,
+        'cmake -B tmp_build -DCMAKE_BUILD_TYPE=Release -DFAST_MATH=ON',
         'cmake --build tmp_build --target burg -j 4',
       ],
-      run: './tmp_build/burg',
+      engines: estimators,
       clean: 'rm -r tmp_build',
     },
   ];
@@ -124,14 +72,17 @@ burgCommand.action(async (options) => {
         await exec(compile_cmd);
       }
 
-      // Run
-      await exec(command.run, {
-        stdio: [
-          0,
-          openSync(join(output, `${command.cmd_name}-${Date.now()}.csv`), 'w'),
-          2,
-        ],
-      });
+      // Run (one .csv per engine in the output directory), with the time of
+      // every fit and predict, which the timing analysis scripts read
+      const command_output = join(output, command.cmd_name);
+      await mkdir(command_output, { recursive: true });
+      await exec([
+        './tmp_build/burg',
+        '-o',
+        command_output,
+        '--raw-times',
+        ...command.engines.map((engine) => `${engine}_${TYPE}`),
+      ]);
 
       // Clean
       await exec(command.clean);
@@ -16,19 +16,19 @@ show_flag = False
 data_type = numpy.double
 
 names_to_names = {
-    'burg-basic': 'Burg\'s method',
-    'burg-optimized-den': 'Denominator optimization',
-    'burg-optimized-den-sqrt': 'Hybrid denominator',
-    'compensated-burg-basic': 'Burg\'s method (compensated)',
-    'compensated-burg-optimized-den': 'Den. opt. (compensated)',
-    'compensated-burg-optimized-den-sqrt': 'Hybrid den. (compensated)'
+    'burg_basic': 'Burg\'s method',
+    'burg_optimized_den': 'Denominator optimization',
+    'burg_optimized_den_sqrt': 'Hybrid denominator',
+    'compensated_burg_basic': 'Burg\'s method (compensated)',
+    'compensated_burg_optimized_den': 'Den. opt. (compensated)',
+    'compensated_burg_optimized_den_sqrt': 'Hybrid den. (compensated)'
 }
 
 def process_file(filepath: str):
-    algo = '-'.join(path.splitext(path.basename(filepath))[0].split('-')[0:-1])
+    algo = utils.get_algo(filepath)
     if not show_flag:
         use('Agg') # Non interactive mode of matplotlib to free memory
-        plot_root_dir = path.join(config.AR_MODEL_PLOT_DIRECTORY, 'error', path.splitext(path.basename(filepath))[0])
+        plot_root_dir = path.join(config.AR_MODEL_PLOT_DIRECTORY, 'error', algo)
         makedirs(plot_root_dir, exist_ok=True)
     
     with open(filepath) as f:
@@ -45,7 +45,7 @@ def process_file(filepath: str):
             pyplot.figure(figsize=(10, 6))
             pyplot.plot(range(len(ar_predictions)), ar_predictions)
             pyplot.ylim(-1.5, 1.5)
-            pyplot.title(f'{names_to_names[algo] if algo in names_to_names else algo} {train_size}-{order}', pad=20)  # Title
+            pyplot.title(f'{utils.get_label(algo, names_to_names)} {train_size}-{order}', pad=20)  # Title
             pyplot.xlabel('Sample', labelpad=10)
             pyplot.ylabel('Gain', labelpad=10)
 
@@ -18,22 +18,22 @@ num_pred = 2560
 specific_train_sizes = []
 
 names_to_names = {
-    'burg-basic': 'Burg\'s method',
-    'burg-optimized-den': 'Denominator optimization',
-    'burg-optimized-den-sqrt': 'Hybrid denominator',
-    'compensated-burg-basic': 'Burg\'s method (compensated)',
-    'compensated-burg-optimized-den': 'Den. opt. (compensated)',
-    'compensated-burg-optimized-den-sqrt': 'Hybrid den. (compensated)'
+    'burg_basic': 'Burg\'s method',
+    'burg_optimized_den': 'Denominator optimization',
+    'burg_optimized_den_sqrt': 'Hybrid denominator',
+    'compensated_burg_basic': 'Burg\'s method (compensated)',
+    'compensated_burg_optimized_den': 'Den. opt. (compensated)',
+    'compensated_burg_optimized_den_sqrt': 'Hybrid den. (compensated)'
 }
 
 if not show_flag:
     use('Agg')
 
 def process_file(filepath: str):
-    algo = '-'.join(path.splitext(path.basename(filepath))[0].split('-')[0:-1])
+    algo = utils.get_algo(filepath)
     if not show_flag:
         use('Agg') # Non interactive mode of matplotlib to free memory
-        plot_root_dir = path.join(config.AR_MODEL_PLOT_DIRECTORY, 'error', path.splitext(path.basename(filepath))[0])
+        plot_root_dir = path.join(config.AR_MODEL_PLOT_DIRECTORY, 'error', algo)
         makedirs(plot_root_dir, exist_ok=True)
     
     results = {}
@@ -106,7 +106,7 @@ if __name__ == '__main__':
         ax = pyplot.gca()
         handles, labels = ax.get_legend_handles_labels()
 
-        # pyplot.title(f'{names_to_names[algo] if algo in names_to_names else algo}', pad=20)  # Title
+        # pyplot.title(f'{utils.get_label(algo, names_to_names)}', pad=20)  # Title
         pyplot.ylim([-0.05, 0.65])
         # Show legend only if the category is
         pyplot.gcf().set_tight_layout(True)  # Make sure that text is not cut out
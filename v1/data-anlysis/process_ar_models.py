@@ -17,7 +17,7 @@ group1_categories = ['violin', 'drums', 'piano']
 
 
 def process_file(csv_filepath: str):
-    csv_filename = path.splitext(path.basename(csv_filepath))[0]
+    csv_filename = utils.get_algo(csv_filepath)
 
     if not show_flag:
         use('Agg') # Non interactive mode of matplotlib to free memory
@@ -68,8 +68,6 @@ def process_file(csv_filepath: str):
             lag = stat['lag']
             ar_mae = stat['ar_mae']
             ar_rmse = stat['ar_rmse']
-            ar_fit_time = stat['ar_fit_time']
-            ar_predict_time = stat['ar_predict_time']
 
             if train_size not in results_by_categories[category]:
                 results_by_categories[category][train_size] = {}
@@ -84,6 +82,10 @@ def process_file(csv_filepath: str):
             results_by_categories[category][train_size][lag]['ar_mae'] += ar_mae
             results_by_categories[category][train_size][lag]['ar_rmse'] += ar_rmse
 
+            # The times of every position are only written by burg --raw-times
+            if 'ar_fit_time' not in stat:
+                continue
+
             if train_size not in results_time:
                 results_time[train_size] = {}
 
@@ -94,8 +96,8 @@ def process_file(csv_filepath: str):
                 }
             
             # Append values
-            results_time[train_size][lag]['ar_fit_time'] += ar_fit_time
-            results_time[train_size][lag]['ar_predict_time'] += ar_predict_time
+            results_time[train_size][lag]['ar_fit_time'] += stat['ar_fit_time']
+            results_time[train_size][lag]['ar_predict_time'] += stat['ar_predict_time']
 
 
         benchmarks_by_category[category]['b0']['mae'] += b0['mae']
@@ -364,6 +366,10 @@ def process_file(csv_filepath: str):
         
         pyplot.close()
 
+    # Without the raw times there are only the latency histograms, so no time plots
+    if not mean_variance_time:
+        return
+
     # Create a new figure
     pyplot.rc('font', size=16)
     pyplot.figure()
@@ -426,6 +432,9 @@ def process_file(csv_filepath: str):
 if __name__ == '__main__':
     for (root,dirs,files) in walk(path.join(config.ROOT_DIR, "results-dataset_double"), topdown=True):
         for name in files:
+            # Only the per engine results, not the latency histograms
+            if not name.endswith('.csv'):
+                continue
             filepath = path.join(root, name)
             print(path.relpath(filepath, path.abspath('.')))
             process_file(filepath)
@@ -16,7 +16,7 @@ show_confidence_intervals_flag = True
 show_flag = False
 
 def process_file(csv_filepath: str):
-    csv_filename = path.splitext(path.basename(csv_filepath))[0]
+    csv_filename = utils.get_algo(csv_filepath)
 
     if not show_flag:
         use('Agg') # Non interactive mode of matplotlib to free memory
@@ -135,6 +135,9 @@ def process_file(csv_filepath: str):
 if __name__ == '__main__':
     for (root,dirs,files) in walk(path.join(config.ROOT_DIR, "results-dataset_double"), topdown=True):
         for name in files:
+            # Only the per engine results, not the latency histograms
+            if not name.endswith('.csv'):
+                continue
             filepath = path.join(root, name)
             print(path.relpath(filepath, path.abspath('.')))
             process_file(filepath)
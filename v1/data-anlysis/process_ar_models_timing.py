@@ -15,10 +15,7 @@ show_confidence_intervals_flag = True
 show_multiplier_wrt_512_1 = False
 
 
-def get_algo(file_path: str):
-    return '-'.join(path.splitext(path.basename(file_path))[0].split('-')[0:-1])
-
-
+# The times of every position are only in the results of a run with --raw-times
 def process_file(csv_filepath: str):
     # Read csv
     df = pandas.read_csv(csv_filepath)
@@ -147,8 +144,11 @@ if __name__ == '__main__':
     results = list()
     for (root, dirs, files) in walk(path.join(config.ROOT_DIR, "results-dataset_double"), topdown=True):
         for name in files:
-            algo = get_algo(name)
+            # Only the per engine results, not the latency histograms
+            if not name.endswith('.csv'):
+                continue
             filepath = path.join(root, name)
+            algo = utils.get_algo(filepath)
             print(path.relpath(filepath, path.abspath('.')))
             stats = process_file(filepath)
             if show_multiplier_wrt_512_1:
@@ -1,4 +1,40 @@
 import os
 
 def get_category(filename):
-    return filename.split(os.sep)[-2]
\ No newline at end of file
+    return filename.split(os.sep)[-2]
+
+
+# Results of the build with -DFAST_MATH=ON, which have the same file names
+FAST_MATH_DIR = 'fast_math'
+
+# Longest first, so that e.g. long_double is not taken for double
+TYPES = ['long_double', 'double_double', 'double', 'float']
+
+
+def get_algo(filepath):
+    # Engine of a result file, <estimator>_<type>[_acc_<accumulator type>], with _fast_math for the fast math build
+    algo = os.path.splitext(os.path.basename(filepath))[0]
+    if get_category(filepath) == FAST_MATH_DIR:
+        algo += '_' + FAST_MATH_DIR
+    return algo
+
+
+def get_label(algo, labels):
+    # Label of the estimator of the engine, followed by its accumulator type and by the fast math marker
+    fast_math = algo.endswith('_' + FAST_MATH_DIR)
+    if fast_math:
+        algo = algo[:-len(FAST_MATH_DIR) - 1]
+
+    engine, _, acc = algo.partition('_acc_')
+    estimator = engine
+    for t in TYPES:
+        if engine.endswith('_' + t):
+            estimator = engine[:-len(t) - 1]
+            break
+
+    label = labels.get(estimator, estimator)
+    if acc:
+        label += f' ({acc} acc.)'
+    if fast_math:
+        label += ' (fast math)'
+    return label
@@ -0,0 +1,138 @@
+#ifndef __AR_PREDICTOR_HPP__
+#define __AR_PREDICTOR_HPP__
+
+#include <type_traits>
+#include <vector>
+#include <algorithm>
+#include "type_details.hpp"
+#include "la.hpp"
+
+/**
+ * @brief Predictor of an AR model, allocation free once constructed.
+ * The last order samples are kept, newest first, in a mirrored ring buffer: every sample is stored
+ * at slot and slot + order, so the window of the last order samples is always contiguous and each
+ * prediction is a single dot product with the negated coefficients, with no gather and no branch.
+ *
+ * It serves both a whole horizon (predict(predictions, n)) and one sample at a time
+ * (predict() for the next sample, update() to feed the sample that actually came)
+ *
+ * @tparam T a float/double/long double type
+ */
+template <typename T, std::enable_if_t<true == is_real<T>(), bool> = true>
+class ar_predictor
+{
+private:
+    std::size_t order;
+    std::vector<T> c;       // Negated AR coefficients a[1], ..., a[order]
+    std::vector<T> ring;    // Last order samples, newest first, mirrored: ring[i] == ring[i + order]
+    std::vector<T> scratch; // Mirrored ring of the horizon predictions
+    std::size_t head;       // Slot of the newest sample
+
+    /**
+     * @brief Stores x as the newest sample of the mirrored ring r whose newest slot is h
+     */
+    void push(T *r, std::size_t &h, T x) const
+    {
+        h = (h == 0 ? order : h) - 1;
+        r[h] = x;
+        r[h + order] = x;
+    }
+
+public:
+    /**
+     * @brief Predictor for models up to max_order
+     */
+    ar_predictor(const std::size_t max_order) : order{0}, c(max_order), ring(2 * max_order), scratch(2 * max_order), head{0} {}
+
+    /**
+     * @brief Sets the AR coefficients a of the given order (order + 1 elements, a[0] = 1) and the
+     * history from the N given samples, zeros before the first one
+     */
+    void reset(const T *a, std::size_t order, const T *samples, std::size_t N)
+    {
+        this->order = order;
+        head = 0;
+
+        for (std::size_t j = 0; j < order; ++j)
+        {
+            c[j] = -a[j + 1];
+            ring[j] = ring[j + order] = j < N ? samples[N - 1 - j] : 0;
+        }
+    }
+
+    /**
+     * @brief Replaces the AR coefficients, of the same order, keeping the history
+     */
+    void set_coefficients(const T *a)
+    {
+        for (std::size_t j = 0; j < order; ++j)
+        {
+            c[j] = -a[j + 1];
+        }
+    }
+
+    /**
+     * @brief Feeds the sample that followed the history
+     */
+    void update(T x)
+    {
+        if (order > 0)
+        {
+            push(ring.data(), head, x);
+        }
+    }
+
+    /**
+     * @brief The prediction of the sample following the history
+     */
+    T predict() const
+    {
+        return la::prod::dot(&ring[head], c.data(), order);
+    }
+
+    /**
+     * @brief Predicts the n samples following the history, writing them in predictions.
+     * The history is left as it is. O(order + n * order)
+     *
+     * @param dot the dot product of two arrays of T, e.g. a compensated one
+     */
+    template <typename Dot>
+    void predict(T *predictions, std::size_t n, Dot dot)
+    {
+        if (order == 0)
+        {
+            std::fill(predictions, predictions + n, 0);
+            return;
+        }
+
+        std::copy(ring.begin(), ring.begin() + 2 * order, scratch.begin());
+        std::size_t h = head;
+
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            predictions[i] = dot(&scratch[h], c.data(), order);
+            push(scratch.data(), h, predictions[i]);
+        }
+    }
+
+    void predict(T *predictions, std::size_t n)
+    {
+        predict(predictions, n, [](const T *x, const T *y, std::size_t N)
+                { return la::prod::dot(x, y, N); });
+    }
+
+    std::size_t get_order() const
+    {
+        return order;
+    }
+
+    /**
+     * @brief The largest order the predictor can serve
+     */
+    std::size_t max_order() const
+    {
+        return c.size();
+    }
+};
+
+#endif
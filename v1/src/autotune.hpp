@@ -0,0 +1,367 @@
+#ifndef __AUTOTUNE_HPP__
+#define __AUTOTUNE_HPP__
+
+#include <type_traits>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+#include "registry.hpp"
+#include "simd.hpp"
+#include "timer.hpp"
+#include "logger.hpp"
+
+/**
+ * @brief Picks the fastest implementation per (window size, order) from micro-benchmarks on the machine.
+ * tune() times every candidate engine with every instruction set on synthetic windows over a grid of
+ * sizes and measures its accuracy against a long double fit. The profile is saved as JSON, and
+ * profile::select() later dispatches a request to the fastest candidate of the nearest grid point within
+ * an accuracy bound. Only burg-plc dispatches through a profile: its single model fits one (size, order)
+ * at a time, while burg fits every train size and lag value concurrently with the same kernels, which
+ * are selected for the whole process
+ */
+namespace autotune
+{
+    /**
+     * @brief An engine with an instruction set, measured at a grid point
+     */
+    struct candidate
+    {
+        std::string engine; // Registry name, e.g. burg_basic_double
+        std::string isa;    // Kernels, e.g. avx2
+        double fit_ns;      // Fastest of the timed fits
+        double error;       // Largest |k - k_ref| of the reflection coefficients on the synthetic windows
+    };
+
+    struct point
+    {
+        std::string type; // Data type suffix, e.g. double
+        std::size_t size;
+        std::size_t order;
+        std::vector<candidate> candidates;
+    };
+
+    /**
+     * @brief What profile::select() dispatches to
+     */
+    template <typename T>
+    struct decision
+    {
+        registry::entry<T> engine;
+        la::simd::isa isa;
+        double fit_ns;
+        double error;
+    };
+
+    struct tune_options
+    {
+        std::vector<std::size_t> sizes;
+        std::vector<std::size_t> orders;
+        std::vector<la::simd::isa> isas; // Supported by the CPU
+        std::size_t windows{4}; // Synthetic windows per size
+        std::size_t reps{5};    // Timed fits per candidate, the fastest one is kept
+    };
+
+    class profile
+    {
+    private:
+        std::vector<point> points;
+
+        /**
+         * @brief The smallest grid value not below v, the largest one if there is none
+         */
+        static std::size_t nearest(const std::vector<std::size_t> &grid, std::size_t v)
+        {
+            std::size_t best = 0;
+
+            for (auto g : grid)
+            {
+                if ((g >= v && (best < v || g < best)) || (best < v && g > best))
+                {
+                    best = g;
+                }
+            }
+
+            return best;
+        }
+
+    public:
+        void add(point p)
+        {
+            points.push_back(std::move(p));
+        }
+
+        const std::vector<point> &get_points() const
+        {
+            return points;
+        }
+
+        /**
+         * @brief Whether the profile has points of type T
+         */
+        template <typename T>
+        bool covers() const
+        {
+            const std::string type = registry::type_suffix<T>();
+
+            return std::any_of(points.begin(), points.end(), [&type](const point &p)
+                               { return p.type == type; });
+        }
+
+        /**
+         * @brief The fastest candidate of type T whose error is within max_error, at the grid point of the
+         * nearest size and order (the smallest ones not below the requested ones). If none is accurate
+         * enough, the most accurate one. Throws if the profile has no point of type T
+         */
+        template <typename T>
+        decision<T> select(std::size_t size, std::size_t order, double max_error) const
+        {
+            const std::string type = registry::type_suffix<T>();
+            std::vector<std::size_t> sizes, orders;
+
+            for (const auto &p : points)
+            {
+                if (p.type == type)
+                {
+                    sizes.push_back(p.size);
+                    orders.push_back(p.order);
+                }
+            }
+
+            if (sizes.empty())
+            {
+                throw std::runtime_error("the profile has no " + type + " engine");
+            }
+
+            const std::size_t s = nearest(sizes, size);
+            const std::size_t o = nearest(orders, order);
+
+            for (const auto &p : points)
+            {
+                if (p.type != type || p.size != s || p.order != o || p.candidates.empty())
+                {
+                    continue;
+                }
+
+                const candidate *best = nullptr;
+                const candidate *most_accurate = &p.candidates[0];
+
+                for (const auto &c : p.candidates)
+                {
+                    if (c.error <= max_error && (!best || c.fit_ns < best->fit_ns))
+                    {
+                        best = &c;
+                    }
+
+                    if (c.error < most_accurate->error)
+                    {
+                        most_accurate = &c;
+                    }
+                }
+
+                const candidate &c = best ? *best : *most_accurate;
+                auto engines = registry::select<T>({c.engine});
+
+                if (engines.empty())
+                {
+                    throw std::runtime_error("unknown engine " + c.engine + " in the profile");
+                }
+
+                return {engines[0], la::simd::from_name(c.isa), c.fit_ns, c.error};
+            }
+
+            throw std::runtime_error("the profile has no " + type + " point of size " + std::to_string(s) + " and order " + std::to_string(o));
+        }
+
+        nlohmann::ordered_json to_json() const
+        {
+            nlohmann::ordered_json j = nlohmann::ordered_json::array();
+
+            for (const auto &p : points)
+            {
+                nlohmann::ordered_json candidates = nlohmann::ordered_json::array();
+
+                for (const auto &c : p.candidates)
+                {
+                    candidates.push_back({{"engine", c.engine}, {"isa", c.isa}, {"fit_ns", c.fit_ns}, {"error", c.error}});
+                }
+
+                j.push_back({{"type", p.type}, {"size", p.size}, {"order", p.order}, {"candidates", candidates}});
+            }
+
+            return j;
+        }
+
+        void save(const std::string &path) const
+        {
+            std::ofstream out{path};
+
+            if (!out)
+            {
+                throw std::runtime_error(path + " was not created due to some issues");
+            }
+
+            out << to_json().dump(2) << std::endl;
+        }
+
+        static profile load(const std::string &path)
+        {
+            std::ifstream in{path};
+
+            if (!in)
+            {
+                throw std::runtime_error(path + " can not be read");
+            }
+
+            profile res;
+            nlohmann::json j = nlohmann::json::parse(in);
+
+            for (const auto &jp : j)
+            {
+                // The "threads" of the profiles of older versions are ignored
+                point p{jp.at("type"), jp.at("size"), jp.at("order"), {}};
+
+                for (const auto &jc : jp.at("candidates"))
+                {
+                    p.candidates.push_back({jc.at("engine"), jc.at("isa"), jc.at("fit_ns"), jc.at("error")});
+                }
+
+                res.add(std::move(p));
+            }
+
+            return res;
+        }
+    };
+
+    /**
+     * @brief A window of N samples of a few sinusoids of random frequencies, amplitudes and phases
+     * in white noise, deterministic for a given seed
+     */
+    template <typename T>
+    std::vector<T> synthetic_window(std::size_t N, uint64_t seed)
+    {
+        std::mt19937_64 gen{seed};
+        std::uniform_real_distribution<double> frequency{0.005, 0.2}, amplitude{0.1, 0.5}, phase{0, 2 * M_PI};
+        std::normal_distribution<double> noise{0, 1e-2};
+
+        double f[4], a[4], p[4];
+        for (int m = 0; m < 4; ++m)
+        {
+            f[m] = frequency(gen);
+            a[m] = amplitude(gen);
+            p[m] = phase(gen);
+        }
+
+        std::vector<T> x(N);
+        for (std::size_t n = 0; n < N; ++n)
+        {
+            double v = noise(gen);
+            for (int m = 0; m < 4; ++m)
+            {
+                v += a[m] * std::sin(2 * M_PI * f[m] * n + p[m]);
+            }
+            x[n] = static_cast<T>(v);
+        }
+
+        return x;
+    }
+
+    /**
+     * @brief Measures the engines of type T with every instruction set of the options over their grid,
+     * adding a point per size and order to the profile. The kernels in use are changed: the caller selects
+     * the ones it wants afterwards
+     */
+    template <typename T>
+    void tune(const std::vector<registry::entry<T>> &engines, const tune_options &opts, profile &prof)
+    {
+        if (engines.empty() || opts.sizes.empty() || opts.orders.empty())
+        {
+            return;
+        }
+
+        const std::size_t max_order = *std::max_element(opts.orders.begin(), opts.orders.end());
+
+        // The kernels only exist for float and double
+        const std::vector<la::simd::isa> isas = la::simd::vectorized<T> ? opts.isas : std::vector<la::simd::isa>{la::simd::isa::SCALAR};
+
+        for (auto N : opts.sizes)
+        {
+            std::vector<std::vector<T>> windows;
+            std::vector<std::vector<long double>> k_ref;
+
+            // Reference reflection coefficients, the ones of an order do not depend on the largest one
+            burg_basic<long double> reference{N};
+            burg_workspace<long double> ws_ref{N};
+            for (std::size_t w = 0; w < opts.windows; ++w)
+            {
+                windows.push_back(synthetic_window<T>(N, w + 1));
+
+                std::vector<long double> x(windows.back().begin(), windows.back().end());
+                k_ref.emplace_back(std::min(max_order, N - 1));
+                reference.fit(x.data(), N, max_order, nullptr, ws_ref, k_ref.back().data());
+            }
+
+            for (auto order : opts.orders)
+            {
+                if (order >= N)
+                {
+                    continue;
+                }
+
+                point p{registry::type_suffix<T>(), N, order, {}};
+                std::vector<T> a(order + 1), k(order);
+                T *a_out = a.data();
+                T *k_out = k.data();
+                T err;
+
+                for (auto id : isas)
+                {
+                    la::simd::select(id);
+
+                    for (const auto &engine : engines)
+                    {
+                        auto model = engine.create(N);
+                        burg_workspace<T> ws{N};
+                        measure::timer timer;
+                        candidate c{engine.name, la::simd::name(id), std::numeric_limits<double>::infinity(), 0};
+
+                        for (std::size_t w = 0; w < windows.size(); ++w)
+                        {
+                            model->fit_orders(windows[w].data(), N, &order, 1, nullptr, &err, ws, &k_out);
+
+                            for (std::size_t j = 0; j < order; ++j)
+                            {
+                                c.error = std::max(c.error, static_cast<double>(std::abs(static_cast<long double>(k[j]) - k_ref[w][j])));
+                            }
+                        }
+
+                        for (std::size_t r = 0; r < opts.reps; ++r)
+                        {
+                            timer.start();
+                            model->fit_orders(windows[r % windows.size()].data(), N, &order, 1, &a_out, &err, ws);
+                            timer.stop();
+
+                            c.fit_ns = std::min(c.fit_ns, timer.get_duration_in_ns());
+                        }
+
+                        p.candidates.push_back(c);
+                    }
+                }
+
+                const auto fastest = std::min_element(p.candidates.begin(), p.candidates.end(), [](const candidate &x, const candidate &y)
+                                                      { return x.fit_ns < y.fit_ns; });
+
+                logger::info(p.type + " " + std::to_string(N) + "/" + std::to_string(order) + ": " + fastest->engine + " with " + fastest->isa + " kernels (" + std::to_string(static_cast<long>(fastest->fit_ns)) + " ns)");
+
+                prof.add(std::move(p));
+            }
+        }
+    }
+}
+
+#endif
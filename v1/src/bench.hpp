@@ -0,0 +1,124 @@
+#ifndef __BENCH_HPP__
+#define __BENCH_HPP__
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <nlohmann/json.hpp>
+#include "timer.hpp"
+
+/**
+ * @brief Repeatable micro-benchmarks: a body is run a few times to warm up the caches and the
+ * branch predictors, then timed over a number of repetitions, each of them running the body enough
+ * times to last at least min_rep_ns, and the times per call are summarized
+ */
+namespace bench
+{
+    struct config
+    {
+        std::size_t warmup{3};          // Untimed repetitions
+        std::size_t reps{15};           // Timed repetitions
+        double min_rep_ns{2e5};         // Shortest timed repetition, the calls per repetition are calibrated on it
+        std::size_t max_calls{1 << 20}; // Most calls per repetition
+    };
+
+    /**
+     * @brief Times per call, in nanoseconds, over the repetitions
+     */
+    struct summary
+    {
+        std::string name;
+        std::size_t calls; // Calls per repetition
+        double min;
+        double median;
+        double mean;
+        double stddev;
+        double max;
+
+        nlohmann::ordered_json to_json() const
+        {
+            return {{"name", name}, {"calls", calls}, {"min_ns", min}, {"median_ns", median}, {"mean_ns", mean}, {"stddev_ns", stddev}, {"max_ns", max}};
+        }
+    };
+
+    /**
+     * @brief Keeps a result alive, so that the timed calls are not optimized away
+     */
+    template <typename T>
+    inline void do_not_optimize(const T &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    /**
+     * @brief Summary of the times per call of the repetitions
+     */
+    inline summary summarize(const std::string &name, std::size_t calls, std::vector<double> times)
+    {
+        std::sort(times.begin(), times.end());
+
+        const std::size_t n = times.size();
+        const double mean = std::accumulate(times.begin(), times.end(), 0.0) / n;
+        double var = 0;
+
+        for (auto t : times)
+        {
+            var += (t - mean) * (t - mean);
+        }
+
+        const double median = n % 2 ? times[n / 2] : (times[n / 2 - 1] + times[n / 2]) / 2;
+
+        return {name, calls, times.front(), median, mean, n > 1 ? std::sqrt(var / (n - 1)) : 0, times.back()};
+    }
+
+    /**
+     * @brief Benchmarks body, a callable without arguments
+     */
+    template <typename F>
+    summary run(const std::string &name, F &&body, const config &cfg = {})
+    {
+        measure::timer timer;
+
+        for (std::size_t i = 0; i < cfg.warmup; ++i)
+        {
+            body();
+        }
+
+        // Doubles the calls per repetition until one lasts min_rep_ns
+        std::size_t calls = 1;
+        for (;;)
+        {
+            timer.start();
+            for (std::size_t i = 0; i < calls; ++i)
+            {
+                body();
+            }
+            timer.stop();
+
+            if (timer.get_duration_in_ns() >= cfg.min_rep_ns || calls >= cfg.max_calls)
+            {
+                break;
+            }
+            calls *= 2;
+        }
+
+        std::vector<double> times(cfg.reps);
+        for (auto &t : times)
+        {
+            timer.start();
+            for (std::size_t i = 0; i < calls; ++i)
+            {
+                body();
+            }
+            timer.stop();
+
+            t = timer.get_duration_in_ns() / calls;
+        }
+
+        return summarize(name, calls, std::move(times));
+    }
+}
+
+#endif
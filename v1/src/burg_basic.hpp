@@ -3,26 +3,33 @@
 
 #include <type_traits>
 #include <vector>
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <assert.h>
 #include <iomanip>
 #include "type_details.hpp"
 #include "logger.hpp"
+#include "burg_workspace.hpp"
+#include "order_selection.hpp"
 #include "la.hpp"
 
-template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
+/**
+ * @tparam T a float/double/long double type, the one of the samples, of the prediction errors and of the coefficients
+ * @tparam Acc the type of the reductions, of the reflection coefficients and of the error (T by default):
+ * a wider type gets more accurate models while the sweeps on the prediction errors move T sized data
+ */
+template <typename T, typename Acc = T, std::enable_if_t<true == is_real<T>() && true == is_real<Acc>(), bool> = true>
 class burg_basic
 {
 private:
     std::size_t max_size;
     std::size_t max_order;
 
-    std::vector<T> f;
-    std::vector<T> b;
+    burg_workspace<T> workspace; // Used by the std::vector based fit/predict
 
 public:
-    burg_basic(const std::size_t max_size) : max_size{max_size}, max_order{max_size - 1}, f(max_size), b(max_size)
+    burg_basic(const std::size_t max_size) : max_size{max_size}, max_order{max_size - 1}, workspace{max_size}
     {
 #ifdef DEBUG
         assert(max_size > 0);
@@ -31,11 +38,11 @@ public:
             std::stringstream s;
 
             s << "[" << __FUNCTION__ << "] - "
-              << "Initialization of BURG's AR model <" << type_name<T>() << ">:"
+              << "Initialization of BURG's AR model <" << type_name<T>() << ", " << type_name<Acc>() << ">:"
               << "\n"
               << "  - max size: " << max_size << "\n"
-              << "  - f size:   " << f.size() << "\n"
-              << "  - b size:   " << b.size() << std::endl;
+              << "  - f size:   " << workspace.f.size() << "\n"
+              << "  - b size:   " << workspace.b.size() << std::endl;
 
             logger::info(s.str(), sizeof(__FUNCTION__) + 2);
         }
@@ -55,16 +62,58 @@ public:
     }
 
     std::pair<std::vector<T>, T> fit(std::vector<T> &samples, std::size_t order)
+    {
+        return fit_orders(samples, {order})[0];
+    }
+
+    /**
+     * @brief Fits a single model, returning its reflection coefficients (k_1 first) instead of
+     * the AR coefficients, see the workspace based fit_orders()
+     */
+    std::pair<std::vector<T>, T> fit_reflection(std::vector<T> &samples, std::size_t order)
+    {
+        std::pair<std::vector<T>, T> model{std::vector<T>(std::min(order, max_order)), 0};
+        model.second = fit(samples.data(), samples.size(), order, nullptr, workspace, model.first.data());
+        return model;
+    }
+
+    /**
+     * @brief Fits a single model of the order chosen by the selection among [0, order], see the workspace
+     * based fit_select(). The size of the AR coefficients is the selected order + 1
+     */
+    std::pair<std::vector<T>, T> fit_select(std::vector<T> &samples, std::size_t order, const order_selection &selection)
+    {
+        std::pair<std::vector<T>, T> model{std::vector<T>(std::min(order, max_order) + 1), 0};
+        std::size_t selected = fit_select(samples.data(), samples.size(), order, selection, model.first.data(), &model.second, workspace);
+        model.first.resize(selected + 1);
+        return model;
+    }
+
+    /**
+     * @brief Fits the models of all the requested orders with a single pass of the order recursion,
+     * taking a snapshot of the AR coefficients and of the error when each order is reached.
+     * The coefficients of orders[k] are written in a_out[k], which must hold min(orders[k], max_order) + 1
+     * elements, and its error in err_out[k]. Only ws is modified, so the fit is reentrant.
+     * If k_out is given, the reflection coefficients of orders[k] (k_1 first) are written in k_out[k],
+     * which must hold min(orders[k], max_order) elements. If a_out is null the AR coefficients are not
+     * computed at all, which saves the O(order^2) updates of the direct form.
+     * If select is given, there is a single model, the best one of the selector among the orders reached,
+     * and the recursion stops as soon as the selector tells so (see fit_select())
+     */
+    void fit_orders(const T *samples, std::size_t N, const std::size_t *orders, std::size_t n_orders, T *const *a_out, T *err_out, burg_workspace<T> &ws, T *const *k_out = nullptr, order_selector *select = nullptr) const
     {
 #ifdef DEBUG
-        assert(order > 0);
-        assert(samples.size() > 0);
+        assert(n_orders > 0);
+        assert(!select || n_orders == 1);
+        assert(*std::min_element(orders, orders + n_orders) > 0);
+        assert(N > 0);
+        assert(std::min(N, max_size) <= ws.size());
 #endif
 
         // Let's find the actual sample size and order
-        std::size_t actual_size = std::min(samples.size(), max_size);
-        std::size_t samples_start = samples.size() - actual_size;
-        std::size_t actual_order = std::min(order, max_order);
+        std::size_t actual_size = std::min(N, max_size);
+        std::size_t samples_start = N - actual_size;
+        std::size_t actual_order = std::min(*std::max_element(orders, orders + n_orders), max_order);
 
 #ifdef DEBUG
         {
@@ -83,18 +132,27 @@ public:
 #endif
 
         // Initialize f and b
-        std::copy(samples.cbegin() + samples_start, samples.cend(), f.begin());
-        std::copy(samples.cbegin() + samples_start, samples.cend(), b.begin());
+        T *f = ws.f.data();
+        T *b = ws.b.data();
+        std::copy(samples + samples_start, samples + N, f);
+        std::copy(samples + samples_start, samples + N, b);
 
-        // Alloc vector with AR coefficients
-        std::vector<T> a(actual_order + 1);
+        // AR coefficients of the current order
+        T *a = ws.a.data();
         a[0] = 1.; // As per burg's specifications
 
+        // Reflection coefficients of the orders so far
+        T *ks = ws.k.data();
+
         // Initialize burg methods variables
-        T ki = 0.;                                                                                                // K at i iteration
-        T num = 0.;                                                                                               // Numerator
-        T den = 0.;                                                                                               // Denominator
-        T err = la::prod::dot_basic(&samples.data()[samples_start], &samples.data()[samples_start], actual_size); // Error
+        Acc ki = 0.;                                                                                              // K at i iteration
+        Acc num = 0.;                                                                                             // Numerator
+        Acc den = 0.;                                                                                             // Denominator
+        Acc err = la::prod::dot<T, Acc>(&samples[samples_start], &samples[samples_start], actual_size);           // Error
+
+        // Reductions of the first order, the ones of the following orders are computed while updating f and b
+        Acc bf, ff, bb;
+        std::tie(bf, ff, bb) = la::lattice::dot_3<T, Acc>(&b[0], &f[1], actual_size - 1);
 
 #ifdef DEBUG
         std::stringstream ss1;
@@ -103,40 +161,77 @@ public:
             << "\n";
 #endif
 
+        // The model of order 0 is the first candidate of the selection
+        if (select)
+        {
+            select->update(0, static_cast<double>(err));
+
+            if (a_out)
+            {
+                a_out[0][0] = 1.;
+            }
+            err_out[0] = static_cast<T>(err);
+        }
+
         // AR main loop
         for (std::size_t i = 1; i <= actual_order; ++i)
         {
-            num = -2 * la::prod::dot_basic(&b.data()[0], &f.data()[i], actual_size - i);
-            den = la::prod::dot_basic(&f.data()[i], &f.data()[i], actual_size - i) + la::prod::dot_basic(&b.data()[0], &b.data()[0], actual_size - i);
+            num = -2 * bf;
+            den = ff + bb;
 
             if (den == 0)
             {
-                den = std::numeric_limits<T>::epsilon();
+                den = std::numeric_limits<Acc>::epsilon();
             }
 
             ki = num / den;
 
-            for (std::size_t j = i; j < actual_size; j++)
+            if (i < actual_order)
             {
-                T bj = b[j - i];
-                T fj = f[j];
-
-                b[j - i] = bj + ki * fj;
-                f[j] = fj + ki * bj;
+                std::tie(bf, ff, bb) = la::lattice::reflect_dot_3(&b[0], &f[i], ki, actual_size - i);
+            }
+            else
+            {
+                la::lattice::reflect(&b[0], &f[i], ki, actual_size - i);
             }
 
-            for (std::size_t j = 1; j <= i / 2; j++)
+            if (a_out)
             {
-                T aj = a[j];
-                T anj = a[i - j];
+                for (std::size_t j = 1; j <= i / 2; j++)
+                {
+                    T aj = a[j];
+                    T anj = a[i - j];
 
-                a[j] = aj + ki * anj;
-                a[i - j] = anj + ki * aj;
+                    a[j] = static_cast<T>(aj + ki * anj);
+                    a[i - j] = static_cast<T>(anj + ki * aj);
+                }
+                a[i] = static_cast<T>(ki);
             }
-            a[i] = ki;
+            ks[i - 1] = static_cast<T>(ki);
 
             err = err * (1 - ki * ki);
 
+            const bool best = select && select->update(i, static_cast<double>(err));
+
+            // Snapshot the requested orders, or the best one of the selection
+            for (std::size_t k = 0; k < n_orders; ++k)
+            {
+                // A reflection coefficient does not change with the order, it goes to every model including it
+                if (k_out && std::min(orders[k], max_order) >= i)
+                {
+                    k_out[k][i - 1] = ks[i - 1];
+                }
+
+                if (select ? best : std::min(orders[k], max_order) == i)
+                {
+                    if (a_out)
+                    {
+                        std::copy(a, a + i + 1, a_out[k]);
+                    }
+                    err_out[k] = static_cast<T>(err);
+                }
+            }
+
 #ifdef DEBUG
             {
                 if (ki >= 1)
@@ -145,7 +240,7 @@ public:
                     s << "[" << __FUNCTION__ << "] - "
                       << "K >=1 !! (" << i << ")"
                       << "\n"
-                      << std::setprecision(type_precision<T>()) << std::scientific
+                      << std::setprecision(type_precision<Acc>()) << std::scientific
                       << "    - K:   " << ki << std::endl;
 
                     logger::error(s.str());
@@ -154,11 +249,16 @@ public:
                 ss1 << "  - "
                     << "Partial results (" << i << ")"
                     << "\n"
-                    << std::setprecision(type_precision<T>()) << std::scientific
+                    << std::setprecision(type_precision<Acc>()) << std::scientific
                     << "    - K:   " << ki << "\n"
                     << "    - err: " << err << std::endl;
             }
 #endif
+
+            if (select && select->stop(i))
+            {
+                break;
+            }
         }
 
 #ifdef DEBUG
@@ -171,11 +271,11 @@ public:
               << "BURG's AR fitted params: "
               << "\n"
               << std::setprecision(type_precision<T>()) << std::scientific
-              << "  - A coefficients: [";
+              << (a_out ? "  - A coefficients: [" : "  - K coefficients: [");
 
-            for (std::size_t i = 0; i < a.size(); ++i)
+            for (std::size_t i = 0; i < actual_order + (a_out ? 1 : 0); ++i)
             {
-                s << (i > 0 ? ", " : "") << a[i];
+                s << (i > 0 ? ", " : "") << (a_out ? a[i] : ks[i]);
             }
 
             s << "]" << std::endl;
@@ -184,26 +284,71 @@ public:
         }
 
 #endif
+    }
 
-        // Return coefficients
-        return {a, err};
+    /**
+     * @brief Fits a single model, see the workspace based fit_orders()
+     *
+     * @return the error of the model
+     */
+    T fit(const T *samples, std::size_t N, std::size_t order, T *a_out, burg_workspace<T> &ws, T *k_out = nullptr) const
+    {
+        T err = 0;
+        fit_orders(samples, N, &order, 1, a_out ? &a_out : nullptr, &err, ws, k_out ? &k_out : nullptr);
+        return err;
     }
 
-    std::vector<T> predict(std::vector<T> &samples, std::vector<T> &a, std::size_t n)
+    /**
+     * @brief Fits a single model, of the order chosen by the criterion of selection among [0, order]:
+     * the recursion stops once the criterion has not improved for selection.patience orders, so the
+     * orders past the optimal one are mostly not computed. The AR coefficients of the selected order are
+     * written in a_out, which must hold min(order, max_order) + 1 elements, and its reflection coefficients
+     * in k_out if given, see the workspace based fit_orders()
+     *
+     * @return the selected order
+     */
+    std::size_t fit_select(const T *samples, std::size_t N, std::size_t order, const order_selection &selection, T *a_out, T *err_out, burg_workspace<T> &ws, T *k_out = nullptr) const
     {
-        std::vector<T> predictions(n);
-        std::vector<T> section(a.size() - 1);
+        order_selector select{selection, std::min(N, max_size)};
+        fit_orders(samples, N, &order, 1, a_out ? &a_out : nullptr, err_out, ws, k_out ? &k_out : nullptr, &select);
+        return select.best_order();
+    }
+
+    /**
+     * @brief Fits the models of all the requested orders, see the workspace based fit_orders().
+     * The models are returned in the same order as the requested ones
+     */
+    std::vector<std::pair<std::vector<T>, T>> fit_orders(std::vector<T> &samples, const std::vector<std::size_t> &orders)
+    {
+        std::vector<std::pair<std::vector<T>, T>> models(orders.size());
+        std::vector<T *> a_out(orders.size());
+        std::vector<T> err_out(orders.size());
 
-        for (ssize_t i = 0; i < static_cast<ssize_t>(n); i++)
+        for (std::size_t k = 0; k < orders.size(); ++k)
         {
-            for (ssize_t j = 1; j < static_cast<ssize_t>(a.size()); j++)
-            {
-                section[j - 1] = -(i - j < 0 ? static_cast<T>(samples[samples.size() + i - j]) : predictions[i - j]);
-            }
+            models[k].first.resize(std::min(orders[k], max_order) + 1);
+            a_out[k] = models[k].first.data();
+        }
+
+        fit_orders(samples.data(), samples.size(), orders.data(), orders.size(), a_out.data(), err_out.data(), workspace);
 
-            predictions[i] = la::prod::dot_basic(&section.data()[0], &a.data()[1], a.size() - 1);
+        for (std::size_t k = 0; k < orders.size(); ++k)
+        {
+            models[k].second = err_out[k];
         }
 
+        return models;
+    }
+
+    /**
+     * @brief Predicts the n samples following the N given ones with the AR coefficients a of the given order,
+     * writing them in predictions. Only ws is modified
+     */
+    void predict(const T *samples, std::size_t N, const T *a, std::size_t order, T *predictions, std::size_t n, burg_workspace<T> &ws) const
+    {
+        ws.predictor.reset(a, order, samples, N);
+        ws.predictor.predict(predictions, n);
+
 #ifdef DEBUG
         {
             std::stringstream s;
@@ -214,7 +359,7 @@ public:
               << std::setprecision(type_precision<T>()) << std::scientific
               << "  - predicted samples: [";
 
-            for (std::size_t i = 0; i < predictions.size(); ++i)
+            for (std::size_t i = 0; i < n; ++i)
             {
                 s << (i > 0 ? ", " : "") << predictions[i];
             }
@@ -225,7 +370,12 @@ public:
         }
 
 #endif
+    }
 
+    std::vector<T> predict(std::vector<T> &samples, std::vector<T> &a, std::size_t n)
+    {
+        std::vector<T> predictions(n);
+        predict(samples.data(), samples.size(), a.data(), a.size() - 1, predictions.data(), n, workspace);
         return predictions;
     }
 };
@@ -0,0 +1,224 @@
+#ifndef __BURG_BATCH_HPP__
+#define __BURG_BATCH_HPP__
+
+#include <type_traits>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <iostream>
+#include <sstream>
+#include <assert.h>
+#include <iomanip>
+#include "type_details.hpp"
+#include "logger.hpp"
+#include "la.hpp"
+
+/**
+ * @brief BURG's AR estimator fitting Lanes independent windows at once.
+ * The windows are interleaved (element j of window l is at [j * Lanes + l]) and the recursion of
+ * burg_basic runs on all of them in lock-step with the la::batch kernels, one window per SIMD lane.
+ * Unlike the reductions over a single window, this keeps the vectors full even for the orders 1..8,
+ * where each window has little work.
+ * The gain is for short windows (up to a few hundred samples): the Lanes interleaved windows must fit
+ * the L1 cache, beyond that the single window kernels are as fast.
+ *
+ * @tparam T a float/double/long double type
+ * @tparam Lanes number of windows fitted together, a multiple of the number of T in a vector register
+ * of the kernels in use (e.g. 8 doubles with AVX-512): the remaining lanes take a slower path
+ */
+template <typename T, std::size_t Lanes, std::enable_if_t<true == is_real<T>() && (Lanes > 0), bool> = true>
+class burg_batch
+{
+private:
+    std::size_t max_size;
+    std::size_t max_order;
+
+    std::vector<T> f; // Interleaved forward prediction errors
+    std::vector<T> b; // Interleaved backward prediction errors
+    std::vector<T> a; // Interleaved AR coefficients of the current order
+
+public:
+    burg_batch(const std::size_t max_size) : max_size{max_size}, max_order{max_size - 1}, f(max_size * Lanes), b(max_size * Lanes), a(max_size * Lanes)
+    {
+#ifdef DEBUG
+        assert(max_size > 0);
+
+        {
+            std::stringstream s;
+
+            s << "[" << __FUNCTION__ << "] - "
+              << "Initialization of batched BURG's AR model <" << type_name<T>() << ", " << Lanes << ">:"
+              << "\n"
+              << "  - max size: " << max_size << "\n"
+              << "  - f size:   " << f.size() << "\n"
+              << "  - b size:   " << b.size() << std::endl;
+
+            logger::info(s.str(), sizeof(__FUNCTION__) + 2);
+        }
+#endif
+    };
+
+    ~burg_batch()
+    {
+#ifdef DEBUG
+        std::stringstream s;
+        s << "[" << __FUNCTION__ << "] - "
+          << "Destruction of batched BURG's AR model " << std::endl;
+
+        logger::info(s.str(), sizeof(__FUNCTION__) + 2);
+
+#endif
+    }
+
+    /**
+     * @brief Fits the models of all the requested orders for each of the Lanes windows of N samples.
+     * A null window leaves its lane idle (its results are not written).
+     * The coefficients of orders[k] for windows[l] are written in a_out[k * Lanes + l], which must hold
+     * min(orders[k], max_order) + 1 elements, and its error in err_out[k * Lanes + l]
+     */
+    void fit_orders(const T *const *windows, std::size_t N, const std::size_t *orders, std::size_t n_orders, T *const *a_out, T *err_out)
+    {
+#ifdef DEBUG
+        assert(n_orders > 0);
+        assert(*std::min_element(orders, orders + n_orders) > 0);
+        assert(N > 0);
+#endif
+
+        // Let's find the actual sample size and order
+        std::size_t actual_size = std::min(N, max_size);
+        std::size_t samples_start = N - actual_size;
+        std::size_t actual_order = std::min(*std::max_element(orders, orders + n_orders), max_order);
+
+        // Initialize f and b, interleaving the windows
+        for (std::size_t l = 0; l < Lanes; ++l)
+        {
+            for (std::size_t j = 0; j < actual_size; ++j)
+            {
+                f[j * Lanes + l] = windows[l] ? windows[l][samples_start + j] : 0;
+            }
+        }
+        std::copy(f.begin(), f.begin() + actual_size * Lanes, b.begin());
+
+        for (std::size_t l = 0; l < Lanes; ++l)
+        {
+            a[l] = 1.; // As per burg's specifications
+        }
+
+        // Initialize burg methods variables, one per window
+        T ki[Lanes];
+        T err[Lanes];
+        T bf[Lanes], ff[Lanes], bb[Lanes];
+
+        // Reductions of the first order, the ones of the following orders are computed while updating f and b
+        la::batch::dot_3(&f[0], &f[0], actual_size, Lanes, err, ff, bb);
+        la::batch::dot_3(&b[0], &f[Lanes], actual_size - 1, Lanes, bf, ff, bb);
+
+        // AR main loop
+        for (std::size_t i = 1; i <= actual_order; ++i)
+        {
+            for (std::size_t l = 0; l < Lanes; ++l)
+            {
+                T den = ff[l] + bb[l];
+                ki[l] = -2 * bf[l] / (den == 0 ? std::numeric_limits<T>::epsilon() : den);
+            }
+
+            la::batch::reflect_dot_3(&b[0], &f[i * Lanes], ki, actual_size - i, Lanes, bf, ff, bb);
+
+            for (std::size_t j = 1; j <= i / 2; j++)
+            {
+                T *aj = &a[j * Lanes];
+                T *anj = &a[(i - j) * Lanes];
+
+                for (std::size_t l = 0; l < Lanes; ++l)
+                {
+                    T aj_old = aj[l];
+                    T anj_old = anj[l];
+
+                    aj[l] = aj_old + ki[l] * anj_old;
+                    anj[l] = anj_old + ki[l] * aj_old;
+                }
+            }
+
+            for (std::size_t l = 0; l < Lanes; ++l)
+            {
+                a[i * Lanes + l] = ki[l];
+                err[l] = err[l] * (1 - ki[l] * ki[l]);
+            }
+
+            // Snapshot the requested orders, de-interleaving the coefficients
+            for (std::size_t k = 0; k < n_orders; ++k)
+            {
+                if (std::min(orders[k], max_order) == i)
+                {
+                    for (std::size_t l = 0; l < Lanes; ++l)
+                    {
+                        if (!windows[l])
+                        {
+                            continue;
+                        }
+
+                        for (std::size_t j = 0; j <= i; ++j)
+                        {
+                            a_out[k * Lanes + l][j] = a[j * Lanes + l];
+                        }
+                        err_out[k * Lanes + l] = err[l];
+                    }
+                }
+            }
+
+#ifdef DEBUG
+            {
+                for (std::size_t l = 0; l < Lanes; ++l)
+                {
+                    if (ki[l] >= 1)
+                    {
+                        std::stringstream s;
+                        s << "[" << __FUNCTION__ << "] - "
+                          << "K >=1 !! (" << i << ", window " << l << ")"
+                          << "\n"
+                          << std::setprecision(type_precision<T>()) << std::scientific
+                          << "    - K:   " << ki[l] << std::endl;
+
+                        logger::error(s.str());
+                    }
+                }
+            }
+#endif
+        }
+    }
+
+    /**
+     * @brief Fits a model of the given order for each window (at most Lanes), see fit_orders()
+     */
+    std::vector<std::pair<std::vector<T>, T>> fit(std::vector<std::vector<T>> &windows, std::size_t order)
+    {
+#ifdef DEBUG
+        assert(windows.size() > 0 && windows.size() <= Lanes);
+        assert(std::all_of(windows.begin(), windows.end(), [&](const std::vector<T> &w)
+                           { return w.size() == windows[0].size(); }));
+#endif
+
+        std::vector<std::pair<std::vector<T>, T>> models(windows.size());
+        const T *in[Lanes] = {};
+        T *a_out[Lanes] = {};
+        T err_out[Lanes];
+
+        for (std::size_t l = 0; l < windows.size(); ++l)
+        {
+            models[l].first.resize(std::min(order, max_order) + 1);
+            in[l] = windows[l].data();
+            a_out[l] = models[l].first.data();
+        }
+
+        fit_orders(in, windows[0].size(), &order, 1, a_out, err_out);
+
+        for (std::size_t l = 0; l < windows.size(); ++l)
+        {
+            models[l].second = err_out[l];
+        }
+
+        return models;
+    }
+};
+
+#endif
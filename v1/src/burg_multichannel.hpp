@@ -0,0 +1,643 @@
+#ifndef __BURG_MULTICHANNEL_HPP__
+#define __BURG_MULTICHANNEL_HPP__
+
+#include <type_traits>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <iostream>
+#include <sstream>
+#include <assert.h>
+#include <iomanip>
+#include "type_details.hpp"
+#include "logger.hpp"
+
+/**
+ * @brief Multichannel BURG's AR estimator (Nuttall-Strand).
+ * The channels are fitted jointly by a single vector AR model
+ *     x[n] = - sum A_j x[n - j] for j in [1, order]
+ * where x[n] is the frame of the m channels at time n and A_j are m x m matrices, so each channel is
+ * also predicted from the past of the others.
+ *
+ * The samples are interleaved frame by frame (sample c of frame n is at [n * m + c], as in a wav file).
+ * At each order the forward and backward reflection matrices minimize the sum of the forward and
+ * backward errors weighted by the inverse of their covariances, which reduces to the BURG's
+ * reflection coefficient for m = 1. The errors are updated and the reductions of the next order are
+ * computed in the same sweep over the frames.
+ *
+ * @tparam T a float/double/long double type
+ */
+template <typename T, std::enable_if_t<true == is_real<T>(), bool> = true>
+class burg_multichannel
+{
+private:
+    std::size_t max_size;
+    std::size_t max_order;
+    std::size_t channels;
+
+    std::vector<T> f; // Forward prediction errors, interleaved
+    std::vector<T> b; // Backward prediction errors, interleaved
+    std::vector<T> a; // Forward matrix coefficients A_0..A_i of the current order
+    std::vector<T> c; // Backward matrix coefficients B_0..B_i of the current order
+
+    // m x m matrices, row major
+    std::vector<T> rff, rbb, rfb; // sum f f', sum b b', sum f b' of the current order
+    std::vector<T> pf, pb;        // Forward and backward error covariances
+    std::vector<T> kf, kb;        // Forward and backward reflection matrices
+    std::vector<T> tmp, tmp2, lu;
+
+    std::vector<T> sylvester; // m^2 x m^2 system of the partial correlation
+    std::vector<T> delta;     // Partial correlation
+    std::vector<T> fn, bn;    // Updated errors of a frame
+
+    inline static const T loading = []
+    {
+        using std::sqrt;
+        return sqrt(std::numeric_limits<T>::epsilon());
+    }(); // See load()
+
+    /**
+     * @brief Solves M X = R in place (R, n x nrhs, is replaced by X) by Gaussian elimination with
+     * partial pivoting. M (n x n) is destroyed, a null pivot is replaced by the epsilon
+     */
+    static void solve(T *M, T *R, std::size_t n, std::size_t nrhs)
+    {
+        using std::abs;
+
+        for (std::size_t col = 0; col < n; ++col)
+        {
+            std::size_t pivot = col;
+            for (std::size_t r = col + 1; r < n; ++r)
+            {
+                if (abs(M[r * n + col]) > abs(M[pivot * n + col]))
+                {
+                    pivot = r;
+                }
+            }
+
+            if (pivot != col)
+            {
+                std::swap_ranges(&M[col * n], &M[col * n] + n, &M[pivot * n]);
+                std::swap_ranges(&R[col * nrhs], &R[col * nrhs] + nrhs, &R[pivot * nrhs]);
+            }
+
+            if (M[col * n + col] == 0)
+            {
+                M[col * n + col] = std::numeric_limits<T>::epsilon();
+            }
+
+            for (std::size_t r = col + 1; r < n; ++r)
+            {
+                T factor = M[r * n + col] / M[col * n + col];
+
+                for (std::size_t k = col; k < n; ++k)
+                {
+                    M[r * n + k] -= factor * M[col * n + k];
+                }
+                for (std::size_t k = 0; k < nrhs; ++k)
+                {
+                    R[r * nrhs + k] -= factor * R[col * nrhs + k];
+                }
+            }
+        }
+
+        for (std::size_t col = n; col-- > 0;)
+        {
+            for (std::size_t k = 0; k < nrhs; ++k)
+            {
+                T s = R[col * nrhs + k];
+
+                for (std::size_t r = col + 1; r < n; ++r)
+                {
+                    s -= M[col * n + r] * R[r * nrhs + k];
+                }
+
+                R[col * nrhs + k] = s / M[col * n + col];
+            }
+        }
+    }
+
+    /**
+     * @brief Loads the diagonal of the m x m matrix M by sqrt(epsilon) times its mean diagonal element,
+     * as if a faint white noise was added to every channel. Correlated channels (e.g. a stereo
+     * file with two equal channels) leave directions with no energy at all: the covariances are
+     * singular and so is the system of the partial correlation, whose rounding errors would grow
+     * order after order. Not needed for a single channel, which is left untouched
+     */
+    void load(T *M) const
+    {
+        const std::size_t m = channels;
+
+        if (m == 1)
+        {
+            return;
+        }
+
+        T trace = 0;
+        for (std::size_t i = 0; i < m; ++i)
+        {
+            trace += M[i * m + i];
+        }
+
+        for (std::size_t i = 0; i < m; ++i)
+        {
+            M[i * m + i] += loading * trace / m;
+        }
+    }
+
+    /**
+     * @brief out = P^-1 X' for a covariance P, all m x m
+     */
+    void solve_transposed(const T *P, const T *X, T *out)
+    {
+        const std::size_t m = channels;
+
+        std::copy(P, P + m * m, lu.begin());
+        load(lu.data());
+        for (std::size_t i = 0; i < m; ++i)
+        {
+            for (std::size_t j = 0; j < m; ++j)
+            {
+                out[i * m + j] = X[j * m + i];
+            }
+        }
+
+        solve(lu.data(), out, m, m);
+    }
+
+    /**
+     * @brief out = X Y, all m x m
+     */
+    void multiply(const T *X, const T *Y, T *out) const
+    {
+        const std::size_t m = channels;
+
+        for (std::size_t i = 0; i < m; ++i)
+        {
+            for (std::size_t j = 0; j < m; ++j)
+            {
+                T s = 0;
+
+                for (std::size_t k = 0; k < m; ++k)
+                {
+                    s += X[i * m + k] * Y[k * m + j];
+                }
+
+                out[i * m + j] = s;
+            }
+        }
+    }
+
+    /**
+     * @brief The reductions rff, rbb and rfb of the frames b[j] and f[j] for j in [0, N)
+     */
+    void reductions(const T *b_in, const T *f_in, std::size_t N)
+    {
+        const std::size_t m = channels;
+
+        std::fill(rff.begin(), rff.end(), 0);
+        std::fill(rbb.begin(), rbb.end(), 0);
+        std::fill(rfb.begin(), rfb.end(), 0);
+
+        for (std::size_t j = 0; j < N; ++j)
+        {
+            const T *bj = &b_in[j * m];
+            const T *fj = &f_in[j * m];
+
+            for (std::size_t r = 0; r < m; ++r)
+            {
+                for (std::size_t s = 0; s < m; ++s)
+                {
+                    rff[r * m + s] += fj[r] * fj[s];
+                    rbb[r * m + s] += bj[r] * bj[s];
+                    rfb[r * m + s] += fj[r] * bj[s];
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Applies the reflection matrices to the frames:
+     * f[j] = f[j] + kf b[j] and b[j] = b[j] + kb f[j] for j in [0, N).
+     * In the same sweep computes the reductions of the next order, where f is shifted by one frame
+     */
+    void reflect_reductions(T *b_io, T *f_io, std::size_t N)
+    {
+        const std::size_t m = channels;
+
+        std::fill(rff.begin(), rff.end(), 0);
+        std::fill(rbb.begin(), rbb.end(), 0);
+        std::fill(rfb.begin(), rfb.end(), 0);
+
+        for (std::size_t j = 0; j < N; ++j)
+        {
+            T *bj = &b_io[j * m];
+            T *fj = &f_io[j * m];
+
+            for (std::size_t r = 0; r < m; ++r)
+            {
+                T fs = fj[r];
+                T bs = bj[r];
+
+                for (std::size_t s = 0; s < m; ++s)
+                {
+                    fs += kf[r * m + s] * bj[s];
+                    bs += kb[r * m + s] * fj[s];
+                }
+
+                fn[r] = fs;
+                bn[r] = bs;
+            }
+
+            std::copy(fn.begin(), fn.end(), fj);
+            std::copy(bn.begin(), bn.end(), bj);
+
+            // The first frame has no predecessor
+            if (j > 0)
+            {
+                const T *b_prev = bj - m; // Already updated
+
+                for (std::size_t r = 0; r < m; ++r)
+                {
+                    for (std::size_t s = 0; s < m; ++s)
+                    {
+                        rff[r * m + s] += fj[r] * fj[s];
+                        rbb[r * m + s] += b_prev[r] * b_prev[s];
+                        rfb[r * m + s] += fj[r] * b_prev[s];
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief reflect_reductions() for M channels known at compile time, keeping the reflection
+     * matrices and the accumulators in registers
+     */
+    template <std::size_t M>
+    void reflect_reductions_fixed(T *b_io, T *f_io, std::size_t N)
+    {
+        T kf_l[M * M], kb_l[M * M];
+        T ff[M * M] = {}, bb[M * M] = {}, fb[M * M] = {};
+        T b_prev[M];
+
+        std::copy(kf.begin(), kf.end(), kf_l);
+        std::copy(kb.begin(), kb.end(), kb_l);
+
+        for (std::size_t j = 0; j < N; ++j)
+        {
+            T *bj = &b_io[j * M];
+            T *fj = &f_io[j * M];
+            T f_new[M], b_new[M];
+
+            for (std::size_t r = 0; r < M; ++r)
+            {
+                T fs = fj[r];
+                T bs = bj[r];
+
+                for (std::size_t s = 0; s < M; ++s)
+                {
+                    fs += kf_l[r * M + s] * bj[s];
+                    bs += kb_l[r * M + s] * fj[s];
+                }
+
+                f_new[r] = fs;
+                b_new[r] = bs;
+            }
+
+            for (std::size_t r = 0; r < M; ++r)
+            {
+                fj[r] = f_new[r];
+                bj[r] = b_new[r];
+            }
+
+            // The first frame has no predecessor
+            if (j > 0)
+            {
+                for (std::size_t r = 0; r < M; ++r)
+                {
+                    for (std::size_t s = 0; s < M; ++s)
+                    {
+                        ff[r * M + s] += f_new[r] * f_new[s];
+                        bb[r * M + s] += b_prev[r] * b_prev[s];
+                        fb[r * M + s] += f_new[r] * b_prev[s];
+                    }
+                }
+            }
+
+            std::copy(b_new, b_new + M, b_prev);
+        }
+
+        std::copy(ff, ff + M * M, rff.begin());
+        std::copy(bb, bb + M * M, rbb.begin());
+        std::copy(fb, fb + M * M, rfb.begin());
+    }
+
+    /**
+     * @brief Dispatches reflect_reductions() to the fixed size versions for mono and stereo
+     */
+    void reflect(T *b_io, T *f_io, std::size_t N)
+    {
+        switch (channels)
+        {
+        case 1:
+            reflect_reductions_fixed<1>(b_io, f_io, N);
+            break;
+        case 2:
+            reflect_reductions_fixed<2>(b_io, f_io, N);
+            break;
+        default:
+            reflect_reductions(b_io, f_io, N);
+        }
+    }
+
+    /**
+     * @brief Computes kf and kb from the reductions and the error covariances.
+     * The partial correlation D solves rff pf^-1 D + D pb^-1 rbb = 2 rfb, then
+     * kf = -D pb^-1 and kb = -D' pf^-1
+     */
+    void reflection()
+    {
+        const std::size_t m = channels;
+        const std::size_t m2 = m * m;
+
+        load(rff.data());
+        load(rbb.data());
+
+        // tmp = pf^-1 rff = (rff pf^-1)', tmp2 = pb^-1 rbb
+        solve_transposed(pf.data(), rff.data(), tmp.data());
+        solve_transposed(pb.data(), rbb.data(), tmp2.data());
+
+        // Unknown D[i][j] at i * m + j
+        std::fill(sylvester.begin(), sylvester.end(), 0);
+        for (std::size_t i = 0; i < m; ++i)
+        {
+            for (std::size_t j = 0; j < m; ++j)
+            {
+                T *row = &sylvester[(i * m + j) * m2];
+
+                for (std::size_t k = 0; k < m; ++k)
+                {
+                    row[k * m + j] += tmp[k * m + i];  // (rff pf^-1)[i][k] D[k][j]
+                    row[i * m + k] += tmp2[k * m + j]; // D[i][k] (pb^-1 rbb)[k][j]
+                }
+
+                delta[i * m + j] = 2 * rfb[i * m + j];
+            }
+        }
+
+        solve(sylvester.data(), delta.data(), m2, 1);
+
+        // kf' = -pb^-1 D', kb' = -pf^-1 D
+        solve_transposed(pb.data(), delta.data(), tmp.data());
+        std::copy(pf.begin(), pf.end(), lu.begin());
+        load(lu.data());
+        std::copy(delta.begin(), delta.end(), tmp2.begin());
+        solve(lu.data(), tmp2.data(), m, m);
+
+        for (std::size_t i = 0; i < m; ++i)
+        {
+            for (std::size_t j = 0; j < m; ++j)
+            {
+                kf[i * m + j] = -tmp[j * m + i];
+                kb[i * m + j] = -tmp2[j * m + i];
+            }
+        }
+    }
+
+    /**
+     * @brief p = p - k1 k2 p, kept symmetric
+     */
+    void update_covariance(std::vector<T> &p, const std::vector<T> &k1, const std::vector<T> &k2)
+    {
+        const std::size_t m = channels;
+
+        multiply(k2.data(), p.data(), tmp.data());
+        multiply(k1.data(), tmp.data(), tmp2.data());
+
+        for (std::size_t i = 0; i < m; ++i)
+        {
+            for (std::size_t j = 0; j <= i; ++j)
+            {
+                T v = ((p[i * m + j] - tmp2[i * m + j]) + (p[j * m + i] - tmp2[j * m + i])) / 2;
+                p[i * m + j] = v;
+                p[j * m + i] = v;
+            }
+        }
+    }
+
+public:
+    burg_multichannel(const std::size_t max_size, const std::size_t channels) : max_size{max_size}, max_order{max_size - 1}, channels{channels},
+                                                                              f(max_size * channels), b(max_size * channels), a(max_size * channels * channels), c(max_size * channels * channels),
+                                                                              rff(channels * channels), rbb(channels * channels), rfb(channels * channels), pf(channels * channels), pb(channels * channels),
+                                                                              kf(channels * channels), kb(channels * channels), tmp(channels * channels), tmp2(channels * channels), lu(channels * channels),
+                                                                              sylvester(channels * channels * channels * channels), delta(channels * channels), fn(channels), bn(channels)
+    {
+#ifdef DEBUG
+        assert(max_size > 0);
+        assert(channels > 0);
+
+        {
+            std::stringstream s;
+
+            s << "[" << __FUNCTION__ << "] - "
+              << "Initialization of multichannel BURG's AR model <" << type_name<T>() << ">:"
+              << "\n"
+              << "  - max size: " << max_size << "\n"
+              << "  - channels: " << channels << "\n"
+              << "  - f size:   " << f.size() << "\n"
+              << "  - b size:   " << b.size() << std::endl;
+
+            logger::info(s.str(), sizeof(__FUNCTION__) + 2);
+        }
+#endif
+    };
+
+    ~burg_multichannel()
+    {
+#ifdef DEBUG
+        std::stringstream s;
+        s << "[" << __FUNCTION__ << "] - "
+          << "Destruction of multichannel BURG's AR model " << std::endl;
+
+        logger::info(s.str(), sizeof(__FUNCTION__) + 2);
+
+#endif
+    }
+
+    /**
+     * @brief Fits the models of all the requested orders on N interleaved frames with a single pass of
+     * the order recursion. The matrix coefficients A_0..A_i of orders[k] (i = min(orders[k], max_order),
+     * (i + 1) * m * m elements, row major) are written in a_out[k] and the m x m forward error
+     * covariance in err_out[k]
+     */
+    void fit_orders(const T *samples, std::size_t N, const std::size_t *orders, std::size_t n_orders, T *const *a_out, T *const *err_out)
+    {
+#ifdef DEBUG
+        assert(n_orders > 0);
+        assert(*std::min_element(orders, orders + n_orders) > 0);
+        assert(N > 0);
+#endif
+
+        const std::size_t m = channels;
+        const std::size_t m2 = m * m;
+
+        // Let's find the actual sample size and order
+        std::size_t actual_size = std::min(N, max_size);
+        std::size_t samples_start = N - actual_size;
+        std::size_t actual_order = std::min(*std::max_element(orders, orders + n_orders), max_order);
+
+        // Initialize f and b
+        std::copy(samples + samples_start * m, samples + N * m, f.begin());
+        std::copy(samples + samples_start * m, samples + N * m, b.begin());
+
+        // A_0 = B_0 = I
+        std::fill(a.begin(), a.begin() + m2, 0);
+        std::fill(c.begin(), c.begin() + m2, 0);
+        for (std::size_t i = 0; i < m; ++i)
+        {
+            a[i * m + i] = 1.;
+            c[i * m + i] = 1.;
+        }
+
+        // The error covariances of order 0
+        reductions(&f[0], &f[0], actual_size);
+        std::copy(rff.begin(), rff.end(), pf.begin());
+        std::copy(rff.begin(), rff.end(), pb.begin());
+
+        // Reductions of the first order, the ones of the following orders are computed while updating f and b
+        reductions(&b[0], &f[m], actual_size - 1);
+
+        // AR main loop
+        for (std::size_t i = 1; i <= actual_order; ++i)
+        {
+            reflection();
+            reflect(&b[0], &f[i * m], actual_size - i);
+
+            // A_j = A_j + kf B_j-1 and B_j = B_j-1 + kb A_j, from the last one so the old values are still there
+            std::fill(a.begin() + i * m2, a.begin() + (i + 1) * m2, 0);
+            for (std::size_t j = i + 1; j-- > 0;)
+            {
+                T *aj = &a[j * m2];
+                T *cj = &c[j * m2];
+
+                if (j > 0)
+                {
+                    const T *cj_prev = &c[(j - 1) * m2];
+
+                    multiply(kf.data(), cj_prev, tmp.data());
+                    multiply(kb.data(), aj, tmp2.data());
+
+                    for (std::size_t r = 0; r < m2; ++r)
+                    {
+                        aj[r] += tmp[r];
+                        cj[r] = cj_prev[r] + tmp2[r];
+                    }
+                }
+                else
+                {
+                    multiply(kb.data(), aj, cj);
+                }
+            }
+
+            update_covariance(pf, kf, kb);
+            update_covariance(pb, kb, kf);
+
+            // Snapshot the requested orders
+            for (std::size_t k = 0; k < n_orders; ++k)
+            {
+                if (std::min(orders[k], max_order) == i)
+                {
+                    std::copy(a.begin(), a.begin() + (i + 1) * m2, a_out[k]);
+                    std::copy(pf.begin(), pf.end(), err_out[k]);
+                }
+            }
+        }
+
+#ifdef DEBUG
+        {
+            std::stringstream s;
+
+            s << "[" << __FUNCTION__ << "] - "
+              << "Multichannel BURG's AR fitted params: "
+              << "\n"
+              << std::setprecision(type_precision<T>()) << std::scientific
+              << "  - error covariance: [";
+
+            for (std::size_t i = 0; i < m2; ++i)
+            {
+                s << (i > 0 ? ", " : "") << pf[i];
+            }
+
+            s << "]" << std::endl;
+
+            logger::info(s.str(), sizeof(__FUNCTION__) + 2);
+        }
+#endif
+    }
+
+    /**
+     * @brief Fits a single model, see fit_orders()
+     *
+     * @return the matrix coefficients and the error covariance
+     */
+    std::pair<std::vector<T>, std::vector<T>> fit(const std::vector<T> &samples, std::size_t order)
+    {
+        std::pair<std::vector<T>, std::vector<T>> model{std::vector<T>((std::min(order, max_order) + 1) * channels * channels), std::vector<T>(channels * channels)};
+        T *a_out = model.first.data();
+        T *err_out = model.second.data();
+
+        fit_orders(samples.data(), samples.size() / channels, &order, 1, &a_out, &err_out);
+
+        return model;
+    }
+
+    /**
+     * @brief Predicts the n frames following the N given ones with the matrix coefficients a of the
+     * given order, writing them (interleaved) in predictions
+     */
+    void predict(const T *samples, std::size_t N, const T *a_in, std::size_t order, T *predictions, std::size_t n)
+    {
+        const std::size_t m = channels;
+        const std::size_t m2 = m * m;
+
+        for (ssize_t i = 0; i < static_cast<ssize_t>(n); i++)
+        {
+            T *x = &predictions[i * m];
+            std::fill(x, x + m, 0);
+
+            for (ssize_t j = 1; j <= static_cast<ssize_t>(order); j++)
+            {
+                const T *past = i - j < 0 ? &samples[(N + i - j) * m] : &predictions[(i - j) * m];
+                const T *aj = &a_in[j * m2];
+
+                for (std::size_t r = 0; r < m; ++r)
+                {
+                    T s = 0;
+
+                    for (std::size_t k = 0; k < m; ++k)
+                    {
+                        s += aj[r * m + k] * past[k];
+                    }
+
+                    x[r] -= s;
+                }
+            }
+        }
+    }
+
+    std::vector<T> predict(const std::vector<T> &samples, const std::vector<T> &a_in, std::size_t n)
+    {
+        std::vector<T> predictions(n * channels);
+        predict(samples.data(), samples.size() / channels, a_in.data(), a_in.size() / (channels * channels) - 1, predictions.data(), n);
+        return predictions;
+    }
+
+    std::size_t get_channels() const
+    {
+        return channels;
+    }
+};
+
+#endif
@@ -0,0 +1,293 @@
+#ifndef __BURG_STREAMING_HPP__
+#define __BURG_STREAMING_HPP__
+
+#include <type_traits>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <iostream>
+#include <sstream>
+#include <assert.h>
+#include <iomanip>
+#include "type_details.hpp"
+#include "logger.hpp"
+#include "ar_predictor.hpp"
+
+/**
+ * @brief Recursive BURG's AR estimator for streams of samples.
+ * Instead of refitting the whole window, every new sample runs once through the lattice and updates
+ * the numerator and the denominator of each stage, so a packet of n samples costs O(n * order).
+ *
+ * The stage sums are weighted by lambda^age and, if window > 0, restricted to the last window samples
+ * (sliding window); with lambda < 1 and no window it is exponentially weighted. The forward and backward
+ * errors of a sample are computed with the reflection coefficients of that time, as in every recursive
+ * lattice, so with lambda = 1 and a window the coefficients only approximate a burg_basic refit of the
+ * window. The difference has no fixed bound: it grows with the order and with the Q of the signal, and
+ * on narrow-band signals at high orders both k and the forecast drift far from the refit. It suits the
+ * cheap tracking of a low-order model, not a substitute for refitting a high-order one.
+ *
+ * @tparam T a float/double/long double type
+ */
+template <typename T, std::enable_if_t<true == is_real<T>(), bool> = true>
+class burg_streaming
+{
+private:
+    std::size_t order;
+    std::size_t window; // 0 if unbounded
+    T lambda;           // Forgetting factor
+    T lambda_window;    // Weight of a contribution when it leaves the window: lambda^window
+
+    std::vector<T> k;   // Reflection coefficient of each stage
+    std::vector<T> num; // Weighted sum of 2 * f[n] * b[n - 1] of each stage
+    std::vector<T> den; // Weighted sum of f[n]^2 + b[n - 1]^2 of each stage
+    T energy;           // Weighted sum of the squared samples
+
+    std::vector<T> b_prev; // Backward errors of the previous sample, of orders [0, order)
+    std::vector<T> b_cur;  // Backward errors of the current sample
+
+    // Contributions of the samples in the window, removed when they leave it
+    std::vector<T> num_ring;
+    std::vector<T> den_ring;
+    std::vector<T> energy_ring;
+    std::size_t head; // Slot of the oldest contribution
+
+    ar_predictor<T> predictor; // Last order samples, used by predict
+    std::size_t count;         // Number of samples seen
+
+    /**
+     * @brief base^e by squaring, for every real type (std::pow is only for the floating point ones)
+     */
+    static T power(T base, std::size_t e)
+    {
+        T res = 1;
+
+        for (; e > 0; e >>= 1, base *= base)
+        {
+            if (e & 1)
+            {
+                res *= base;
+            }
+        }
+        return res;
+    }
+
+    /**
+     * @brief Recomputes the sums from the contributions in the window, so that the rounding errors
+     * of the additions and subtractions do not pile up. Amortized O(order) per sample
+     */
+    void renormalize()
+    {
+        std::fill(num.begin(), num.end(), 0);
+        std::fill(den.begin(), den.end(), 0);
+        energy = 0;
+
+        // From the oldest to the newest contribution
+        for (std::size_t s = 0; s < window; ++s)
+        {
+            std::size_t slot = (head + s) % window;
+
+            for (std::size_t m = 0; m < order; ++m)
+            {
+                num[m] = lambda * num[m] + num_ring[slot * order + m];
+                den[m] = lambda * den[m] + den_ring[slot * order + m];
+            }
+            energy = lambda * energy + energy_ring[slot];
+        }
+    }
+
+public:
+    burg_streaming(const std::size_t order, const std::size_t window, const T lambda = 1) : order{order}, window{window}, lambda{lambda}, lambda_window{power(lambda, window)},
+                                                                                           k(order), num(order), den(order), energy{0}, b_prev(order), b_cur(order),
+                                                                                           num_ring(window * order), den_ring(window * order), energy_ring(window), head{0},
+                                                                                           predictor(order), count{0}
+    {
+        predictor.reset(coefficients().data(), order, nullptr, 0);
+
+#ifdef DEBUG
+        assert(order > 0);
+        assert(lambda > 0 && lambda <= 1);
+        assert(window > 0 || lambda < 1);
+
+        {
+            std::stringstream s;
+
+            s << "[" << __FUNCTION__ << "] - "
+              << "Initialization of streaming BURG's AR model <" << type_name<T>() << ">:"
+              << "\n"
+              << "  - order:  " << order << "\n"
+              << "  - window: " << window << "\n"
+              << "  - lambda: " << lambda << std::endl;
+
+            logger::info(s.str(), sizeof(__FUNCTION__) + 2);
+        }
+#endif
+    };
+
+    ~burg_streaming()
+    {
+#ifdef DEBUG
+        std::stringstream s;
+        s << "[" << __FUNCTION__ << "] - "
+          << "Destruction of streaming BURG's AR model " << std::endl;
+
+        logger::info(s.str(), sizeof(__FUNCTION__) + 2);
+
+#endif
+    }
+
+    /**
+     * @brief Feeds a new sample to the lattice, updating every reflection coefficient. O(order)
+     */
+    void update(T x)
+    {
+        T *old_num = window > 0 ? &num_ring[head * order] : nullptr;
+        T *old_den = window > 0 ? &den_ring[head * order] : nullptr;
+
+        energy = lambda * energy + x * x;
+        if (window > 0)
+        {
+            energy -= lambda_window * energy_ring[head];
+            energy_ring[head] = x * x;
+        }
+
+        T f = x;
+        b_cur[0] = x;
+
+        for (std::size_t m = 0; m < order; ++m)
+        {
+            T bp = b_prev[m];
+
+            T c_num = 2 * f * bp;
+            T c_den = f * f + bp * bp;
+
+            num[m] = lambda * num[m] + c_num;
+            den[m] = lambda * den[m] + c_den;
+
+            if (window > 0)
+            {
+                num[m] -= lambda_window * old_num[m];
+                den[m] -= lambda_window * old_den[m];
+                old_num[m] = c_num;
+                old_den[m] = c_den;
+            }
+
+            T d = den[m] > 0 ? den[m] : std::numeric_limits<T>::epsilon();
+            T ki = -num[m] / d;
+            k[m] = ki;
+
+            // Errors of the next order
+            if (m + 1 < order)
+            {
+                b_cur[m + 1] = bp + ki * f;
+            }
+            f = f + ki * bp;
+        }
+
+        std::swap(b_prev, b_cur);
+
+        predictor.update(x);
+        count++;
+
+        if (window > 0)
+        {
+            head = (head + 1) % window;
+
+            if (head == 0)
+            {
+                renormalize();
+            }
+        }
+    }
+
+    /**
+     * @brief Feeds n new samples, e.g. a packet. O(n * order)
+     */
+    void update(const T *samples, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            update(samples[i]);
+        }
+    }
+
+    /**
+     * @brief The current reflection coefficients, order elements
+     */
+    const std::vector<T> &reflection_coefficients() const
+    {
+        return k;
+    }
+
+    /**
+     * @brief Writes the current AR coefficients (order + 1 elements) in a, like the fit of the
+     * BURG's estimators. O(order^2), computed only when requested
+     */
+    void coefficients(T *a) const
+    {
+        a[0] = 1.;
+
+        for (std::size_t i = 1; i <= order; ++i)
+        {
+            T ki = k[i - 1];
+
+            for (std::size_t j = 1; j <= i / 2; j++)
+            {
+                T aj = a[j];
+                T anj = a[i - j];
+
+                a[j] = aj + ki * anj;
+                a[i - j] = anj + ki * aj;
+            }
+            a[i] = ki;
+        }
+    }
+
+    std::vector<T> coefficients() const
+    {
+        std::vector<T> a(order + 1);
+        coefficients(a.data());
+        return a;
+    }
+
+    /**
+     * @brief The current error, as returned by the fit of the BURG's estimators:
+     * the weighted energy of the samples times the product of (1 - k^2) of the stages
+     */
+    T error() const
+    {
+        T err = energy;
+
+        for (std::size_t m = 0; m < order; ++m)
+        {
+            err = err * (1 - k[m] * k[m]);
+        }
+
+        return err;
+    }
+
+    /**
+     * @brief Predicts the n samples following the last ones fed with the AR coefficients a
+     * (order + 1 elements, see coefficients()), writing them in predictions
+     */
+    void predict(const T *a, T *predictions, std::size_t n)
+    {
+        predictor.set_coefficients(a);
+        predictor.predict(predictions, n);
+    }
+
+    std::size_t get_order() const
+    {
+        return order;
+    }
+
+    /**
+     * @brief Number of samples fed so far
+     */
+    std::size_t size() const
+    {
+        return count;
+    }
+};
+
+#endif
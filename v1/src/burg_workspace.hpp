@@ -0,0 +1,81 @@
+#ifndef __BURG_WORKSPACE_HPP__
+#define __BURG_WORKSPACE_HPP__
+
+#include <type_traits>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "type_details.hpp"
+#include "ar_predictor.hpp"
+
+/**
+ * @brief Drift of the recursive denominator of the optimized_den_sqrt estimators, over the fits using a
+ * workspace. The recursion is checked against the direct denominator at orders further and further apart
+ * while its relative drift stays within the tolerance, and at every order again as soon as it does not
+ */
+struct den_drift_stats
+{
+    std::size_t checks{0};         // Direct denominators computed to check the recursion
+    std::size_t over_tolerance{0}; // Checks whose drift was over the tolerance
+    double max_drift{0};           // Largest relative drift
+    double total_drift{0};         // Sum of the relative drifts of the checks
+
+    /**
+     * @brief Records the check of the recursive denominator against the direct one, which replaces it
+     *
+     * @return the number of orders until the next check: twice interval if the drift is within the
+     * tolerance, up to max_interval, otherwise 1
+     */
+    std::size_t check(double recursive, double direct, double tolerance, std::size_t interval, std::size_t max_interval)
+    {
+        double drift = direct != 0 ? std::abs(recursive - direct) / std::abs(direct) : 0;
+
+        checks++;
+        max_drift = std::max(max_drift, drift);
+        total_drift += drift;
+
+        if (!(drift <= tolerance))
+        {
+            over_tolerance++;
+            return 1;
+        }
+
+        return std::min(2 * interval, max_interval);
+    }
+
+    double mean_drift() const
+    {
+        return checks > 0 ? total_drift / checks : 0;
+    }
+};
+
+/**
+ * @brief Scratch memory of the BURG's estimators, allocated once for the largest window.
+ * The workspace based fit/predict of the estimators keep all their state here and write the results
+ * in buffers owned by the caller, so they are reentrant and, with one workspace per thread,
+ * they never touch the heap
+ *
+ * @tparam T a float/double/long double type
+ */
+template <typename T, std::enable_if_t<true == is_real<T>(), bool> = true>
+struct burg_workspace
+{
+    std::vector<T> f;          // Forward prediction errors
+    std::vector<T> b;          // Backward prediction errors
+    std::vector<T> a;          // AR coefficients of the current order
+    std::vector<T> k;          // Reflection coefficients of the orders so far
+    ar_predictor<T> predictor; // Used by predict
+    den_drift_stats drift;     // Updated by the fits of the optimized_den_sqrt estimators
+
+    burg_workspace(const std::size_t max_size) : f(max_size), b(max_size), a(max_size), k(max_size), predictor(max_size) {}
+
+    /**
+     * @brief The largest window (and order + 1) the workspace can serve
+     */
+    std::size_t size() const
+    {
+        return f.size();
+    }
+};
+
+#endif
@@ -3,12 +3,15 @@
 
 #include <type_traits>
 #include <vector>
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <assert.h>
 #include <iomanip>
 #include "type_details.hpp"
 #include "logger.hpp"
+#include "burg_workspace.hpp"
+#include "order_selection.hpp"
 #include "precise_la.hpp"
 
 template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
@@ -18,11 +21,10 @@ private:
     std::size_t max_size;
     std::size_t max_order;
 
-    std::vector<T> f;
-    std::vector<T> b;
+    burg_workspace<T> workspace; // Used by the std::vector based fit/predict
 
 public:
-    compensated_burg_basic(const std::size_t max_size) : max_size{max_size}, max_order{max_size - 1}, f(max_size), b(max_size)
+    compensated_burg_basic(const std::size_t max_size) : max_size{max_size}, max_order{max_size - 1}, workspace{max_size}
     {
 #ifdef DEBUG
         assert(max_size > 0);
@@ -34,8 +36,8 @@ public:
               << "Initialization of BURG's AR model <" << type_name<T>() << ">:"
               << "\n"
               << "  - max size: " << max_size << "\n"
-              << "  - f size:   " << f.size() << "\n"
-              << "  - b size:   " << b.size() << std::endl;
+              << "  - f size:   " << workspace.f.size() << "\n"
+              << "  - b size:   " << workspace.b.size() << std::endl;
 
             logger::info(s.str(), sizeof(__FUNCTION__) + 2);
         }
@@ -55,16 +57,58 @@ public:
     }
 
     std::pair<std::vector<T>, T> fit(std::vector<T> &samples, std::size_t order)
+    {
+        return fit_orders(samples, {order})[0];
+    }
+
+    /**
+     * @brief Fits a single model, returning its reflection coefficients (k_1 first) instead of
+     * the AR coefficients, see the workspace based fit_orders()
+     */
+    std::pair<std::vector<T>, T> fit_reflection(std::vector<T> &samples, std::size_t order)
+    {
+        std::pair<std::vector<T>, T> model{std::vector<T>(std::min(order, max_order)), 0};
+        model.second = fit(samples.data(), samples.size(), order, nullptr, workspace, model.first.data());
+        return model;
+    }
+
+    /**
+     * @brief Fits a single model of the order chosen by the selection among [0, order], see the workspace
+     * based fit_select(). The size of the AR coefficients is the selected order + 1
+     */
+    std::pair<std::vector<T>, T> fit_select(std::vector<T> &samples, std::size_t order, const order_selection &selection)
+    {
+        std::pair<std::vector<T>, T> model{std::vector<T>(std::min(order, max_order) + 1), 0};
+        std::size_t selected = fit_select(samples.data(), samples.size(), order, selection, model.first.data(), &model.second, workspace);
+        model.first.resize(selected + 1);
+        return model;
+    }
+
+    /**
+     * @brief Fits the models of all the requested orders with a single pass of the order recursion,
+     * taking a snapshot of the AR coefficients and of the error when each order is reached.
+     * The coefficients of orders[k] are written in a_out[k], which must hold min(orders[k], max_order) + 1
+     * elements, and its error in err_out[k]. Only ws is modified, so the fit is reentrant.
+     * If k_out is given, the reflection coefficients of orders[k] (k_1 first) are written in k_out[k],
+     * which must hold min(orders[k], max_order) elements. If a_out is null the AR coefficients are not
+     * computed at all, which saves the O(order^2) updates of the direct form.
+     * If select is given, there is a single model, the best one of the selector among the orders reached,
+     * and the recursion stops as soon as the selector tells so (see fit_select())
+     */
+    void fit_orders(const T *samples, std::size_t N, const std::size_t *orders, std::size_t n_orders, T *const *a_out, T *err_out, burg_workspace<T> &ws, T *const *k_out = nullptr, order_selector *select = nullptr) const
     {
 #ifdef DEBUG
-        assert(order > 0);
-        assert(samples.size() > 0);
+        assert(n_orders > 0);
+        assert(!select || n_orders == 1);
+        assert(*std::min_element(orders, orders + n_orders) > 0);
+        assert(N > 0);
+        assert(std::min(N, max_size) <= ws.size());
 #endif
 
         // Let's find the actual sample size and order
-        std::size_t actual_size = std::min(samples.size(), max_size);
-        std::size_t samples_start = samples.size() - actual_size;
-        std::size_t actual_order = std::min(order, max_order);
+        std::size_t actual_size = std::min(N, max_size);
+        std::size_t samples_start = N - actual_size;
+        std::size_t actual_order = std::min(*std::max_element(orders, orders + n_orders), max_order);
 
 #ifdef DEBUG
         {
@@ -83,20 +127,25 @@ public:
 #endif
 
         // Initialize f and b
-        std::copy(samples.cbegin() + samples_start, samples.cend(), f.begin());
-        std::copy(samples.cbegin() + samples_start, samples.cend(), b.begin());
+        T *f = ws.f.data();
+        T *b = ws.b.data();
+        std::copy(samples + samples_start, samples + N, f);
+        std::copy(samples + samples_start, samples + N, b);
 
-        // Alloc vector with AR coefficients
-        std::vector<T> a(actual_order + 1);
+        // AR coefficients of the current order
+        T *a = ws.a.data();
         a[0] = 1.; // As per burg's specifications
 
+        // Reflection coefficients of the orders so far
+        T *ks = ws.k.data();
+
         // Initialize burg methods variables
         T ki = 0.;  // K at i iteration
         T num = 0.; // Numerator
         T den = 0.; // Denominator
         T err = 0.; // Error
 
-        err = precise_la::utils::sum_pair_elements(precise_la::prod::dot_2(&samples.data()[samples_start], &samples.data()[samples_start], actual_size));
+        err = precise_la::utils::sum_pair_elements(precise_la::prod::dot_2_simd(&samples[samples_start], &samples[samples_start], actual_size));
 
 #ifdef DEBUG
         std::stringstream ss1;
@@ -105,15 +154,27 @@ public:
             << "\n";
 #endif
 
+        // The model of order 0 is the first candidate of the selection
+        if (select)
+        {
+            select->update(0, static_cast<double>(err));
+
+            if (a_out)
+            {
+                a_out[0][0] = 1.;
+            }
+            err_out[0] = err;
+        }
+
         // AR main loop
         for (std::size_t i = 1; i <= actual_order; ++i)
         {
             // Numerator
-            num = precise_la::utils::sum_pair_elements(precise_la::prod::dot_2(&b.data()[0], &f.data()[i], actual_size - i));
+            num = precise_la::utils::sum_pair_elements(precise_la::prod::dot_2_simd(&b[0], &f[i], actual_size - i));
             num = precise_la::utils::sum_pair_elements(precise_la::prod::two_product_FMA(num, static_cast<T>(-2.)));
 
             // Denominator
-            den = precise_la::utils::sum_pair_elements(precise_la::utils::sum_pairs(precise_la::prod::dot_2(&f.data()[i], &f.data()[i], actual_size - i), precise_la::prod::dot_2(&b.data()[0], &b.data()[0], actual_size - i)));
+            den = precise_la::utils::sum_pair_elements(precise_la::utils::sum_pairs(precise_la::prod::dot_2_simd(&f[i], &f[i], actual_size - i), precise_la::prod::dot_2_simd(&b[0], &b[0], actual_size - i)));
 
             if (den == 0)
             {
@@ -122,26 +183,44 @@ public:
 
             ki = precise_la::utils::sum_pair_elements(precise_la::prod::two_product_FMA(num, 1 / den));
 
-            for (std::size_t j = i; j < actual_size; j++)
+            precise_la::lattice::reflect(&b[0], &f[i], ki, actual_size - i);
+
+            if (a_out)
             {
-                T bj = b[j - i];
-                T fj = f[j];
+                for (std::size_t j = 1; j <= i / 2; j++)
+                {
+                    T aj = a[j];
+                    T anj = a[i - j];
 
-                b[j - i] = precise_la::utils::sum_pair_elements(precise_la::utils::sum_pairs({bj, 0}, precise_la::prod::two_product_FMA(ki, fj)));
-                f[j] = precise_la::utils::sum_pair_elements(precise_la::utils::sum_pairs({fj, 0}, precise_la::prod::two_product_FMA(ki, bj)));
+                    a[j] = precise_la::utils::sum_pair_elements(precise_la::utils::sum_pairs({aj, 0}, precise_la::prod::two_product_FMA(ki, anj)));
+                    a[i - j] = precise_la::utils::sum_pair_elements(precise_la::utils::sum_pairs({anj, 0}, precise_la::prod::two_product_FMA(ki, aj)));
+                }
+                a[i] = ki;
             }
+            ks[i - 1] = ki;
 
-            for (std::size_t j = 1; j <= i / 2; j++)
+            err = precise_la::utils::sum_pair_elements(precise_la::prod::two_product_FMA(err, precise_la::utils::sum_pair_elements(precise_la::utils::sum_pairs({1, 0}, precise_la::prod::two_product_FMA(ki, -ki)))));
+
+            const bool best = select && select->update(i, static_cast<double>(err));
+
+            // Snapshot the requested orders, or the best one of the selection
+            for (std::size_t k = 0; k < n_orders; ++k)
             {
-                T aj = a[j];
-                T anj = a[i - j];
+                // A reflection coefficient does not change with the order, it goes to every model including it
+                if (k_out && std::min(orders[k], max_order) >= i)
+                {
+                    k_out[k][i - 1] = ks[i - 1];
+                }
 
-                a[j] = precise_la::utils::sum_pair_elements(precise_la::utils::sum_pairs({aj, 0}, precise_la::prod::two_product_FMA(ki, anj)));
-                a[i - j] = precise_la::utils::sum_pair_elements(precise_la::utils::sum_pairs({anj, 0}, precise_la::prod::two_product_FMA(ki, aj)));
+                if (select ? best : std::min(orders[k], max_order) == i)
+                {
+                    if (a_out)
+                    {
+                        std::copy(a, a + i + 1, a_out[k]);
+                    }
+                    err_out[k] = err;
+                }
             }
-            a[i] = ki;
-
-            err = precise_la::utils::sum_pair_elements(precise_la::prod::two_product_FMA(err, precise_la::utils::sum_pair_elements(precise_la::utils::sum_pairs({1, 0}, precise_la::prod::two_product_FMA(ki, -ki)))));
 
 #ifdef DEBUG
             {
@@ -165,6 +244,11 @@ public:
                     << "    - err: " << err << std::endl;
             }
 #endif
+
+            if (select && select->stop(i))
+            {
+                break;
+            }
         }
 
 #ifdef DEBUG
@@ -177,11 +261,11 @@ public:
               << "BURG's AR fitted params: "
               << "\n"
               << std::setprecision(type_precision<T>()) << std::scientific
-              << "  - A coefficients: [";
+              << (a_out ? "  - A coefficients: [" : "  - K coefficients: [");
 
-            for (std::size_t i = 0; i < a.size(); ++i)
+            for (std::size_t i = 0; i < actual_order + (a_out ? 1 : 0); ++i)
             {
-                s << (i > 0 ? ", " : "") << a[i];
+                s << (i > 0 ? ", " : "") << (a_out ? a[i] : ks[i]);
             }
 
             s << "]" << std::endl;
@@ -190,26 +274,72 @@ public:
         }
 
 #endif
+    }
 
-        // Return coefficients
-        return {a, err};
+    /**
+     * @brief Fits a single model, see the workspace based fit_orders()
+     *
+     * @return the error of the model
+     */
+    T fit(const T *samples, std::size_t N, std::size_t order, T *a_out, burg_workspace<T> &ws, T *k_out = nullptr) const
+    {
+        T err = 0;
+        fit_orders(samples, N, &order, 1, a_out ? &a_out : nullptr, &err, ws, k_out ? &k_out : nullptr);
+        return err;
     }
 
-    std::vector<T> predict(std::vector<T> &samples, std::vector<T> &a, std::size_t n)
+    /**
+     * @brief Fits a single model, of the order chosen by the criterion of selection among [0, order]:
+     * the recursion stops once the criterion has not improved for selection.patience orders, so the
+     * orders past the optimal one are mostly not computed. The AR coefficients of the selected order are
+     * written in a_out, which must hold min(order, max_order) + 1 elements, and its reflection coefficients
+     * in k_out if given, see the workspace based fit_orders()
+     *
+     * @return the selected order
+     */
+    std::size_t fit_select(const T *samples, std::size_t N, std::size_t order, const order_selection &selection, T *a_out, T *err_out, burg_workspace<T> &ws, T *k_out = nullptr) const
     {
-        std::vector<T> predictions(n);
-        std::vector<T> section(a.size() - 1);
+        order_selector select{selection, std::min(N, max_size)};
+        fit_orders(samples, N, &order, 1, a_out ? &a_out : nullptr, err_out, ws, k_out ? &k_out : nullptr, &select);
+        return select.best_order();
+    }
 
-        for (ssize_t i = 0; i < static_cast<ssize_t>(n); i++)
+    /**
+     * @brief Fits the models of all the requested orders, see the workspace based fit_orders().
+     * The models are returned in the same order as the requested ones
+     */
+    std::vector<std::pair<std::vector<T>, T>> fit_orders(std::vector<T> &samples, const std::vector<std::size_t> &orders)
+    {
+        std::vector<std::pair<std::vector<T>, T>> models(orders.size());
+        std::vector<T *> a_out(orders.size());
+        std::vector<T> err_out(orders.size());
+
+        for (std::size_t k = 0; k < orders.size(); ++k)
         {
-            for (ssize_t j = 1; j < static_cast<ssize_t>(a.size()); j++)
-            {
-                section[j - 1] = -(i - j < 0 ? static_cast<T>(samples[samples.size() + i - j]) : predictions[i - j]);
-            }
+            models[k].first.resize(std::min(orders[k], max_order) + 1);
+            a_out[k] = models[k].first.data();
+        }
+
+        fit_orders(samples.data(), samples.size(), orders.data(), orders.size(), a_out.data(), err_out.data(), workspace);
 
-            predictions[i] = precise_la::utils::sum_pair_elements(precise_la::prod::dot_2(&section.data()[0], &a.data()[1], a.size() - 1));
+        for (std::size_t k = 0; k < orders.size(); ++k)
+        {
+            models[k].second = err_out[k];
         }
 
+        return models;
+    }
+
+    /**
+     * @brief Predicts the n samples following the N given ones with the AR coefficients a of the given order,
+     * writing them in predictions. Only ws is modified
+     */
+    void predict(const T *samples, std::size_t N, const T *a, std::size_t order, T *predictions, std::size_t n, burg_workspace<T> &ws) const
+    {
+        ws.predictor.reset(a, order, samples, N);
+        ws.predictor.predict(predictions, n, [](const T *x, const T *y, std::size_t N)
+                             { return precise_la::utils::sum_pair_elements(precise_la::prod::dot_2_simd(x, y, N)); });
+
 #ifdef DEBUG
         {
             std::stringstream s;
@@ -220,7 +350,7 @@ public:
               << std::setprecision(type_precision<T>()) << std::scientific
               << "  - predicted samples: [";
 
-            for (std::size_t i = 0; i < predictions.size(); ++i)
+            for (std::size_t i = 0; i < n; ++i)
             {
                 s << (i > 0 ? ", " : "") << predictions[i];
             }
@@ -231,7 +361,12 @@ public:
         }
 
 #endif
+    }
 
+    std::vector<T> predict(std::vector<T> &samples, std::vector<T> &a, std::size_t n)
+    {
+        std::vector<T> predictions(n);
+        predict(samples.data(), samples.size(), a.data(), a.size() - 1, predictions.data(), n, workspace);
         return predictions;
     }
 };
@@ -0,0 +1,145 @@
+#include "counters.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace measure
+{
+#ifdef __linux__
+    namespace
+    {
+        int open_event(uint32_t type, uint64_t config, int group_fd)
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = group_fd == -1; // The group is enabled through its leader
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+
+            return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+        }
+
+        constexpr uint64_t cache_miss(uint64_t cache)
+        {
+            return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        }
+    }
+
+    counters::counters(bool open) : _values{}
+    {
+        _fds.fill(-1);
+
+        if (!open)
+        {
+            return;
+        }
+
+        _fds[CYCLES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+        if (_fds[CYCLES] < 0)
+        {
+            return;
+        }
+
+        _fds[INSTRUCTIONS] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, _fds[CYCLES]);
+        _fds[L1D_MISSES] = open_event(PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_L1D), _fds[CYCLES]);
+        _fds[LLC_MISSES] = open_event(PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_LL), _fds[CYCLES]);
+        _fds[BRANCH_MISSES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, _fds[CYCLES]);
+    }
+
+    counters::~counters()
+    {
+        for (auto fd : _fds)
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+    }
+
+    void counters::start()
+    {
+        if (!available())
+        {
+            return;
+        }
+
+        ioctl(_fds[CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(_fds[CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    void counters::stop()
+    {
+        if (!available())
+        {
+            return;
+        }
+
+        ioctl(_fds[CYCLES], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        for (std::size_t i = 0; i < _fds.size(); ++i)
+        {
+            uint64_t count = 0;
+
+            if (_fds[i] >= 0 && read(_fds[i], &count, sizeof(count)) != sizeof(count))
+            {
+                count = 0;
+            }
+            _values.counts[i] = count;
+        }
+    }
+#else
+    counters::counters(bool) : _values{}
+    {
+        _fds.fill(-1);
+    }
+
+    counters::~counters() {}
+
+    void counters::start() {}
+
+    void counters::stop() {}
+#endif
+
+    bool counters::available() const
+    {
+        return _fds[CYCLES] >= 0;
+    }
+
+    bool counters::opened(counter_event event) const
+    {
+        return _fds[event] >= 0;
+    }
+
+    counter_values counters::get_values() const
+    {
+        return _values;
+    }
+
+    std::string counters::name(counter_event event)
+    {
+        switch (event)
+        {
+        case CYCLES:
+            return "cycles";
+        case INSTRUCTIONS:
+            return "instructions";
+        case L1D_MISSES:
+            return "l1d_misses";
+        case LLC_MISSES:
+            return "llc_misses";
+        case BRANCH_MISSES:
+            return "branch_misses";
+        default:
+            return "";
+        }
+    }
+}
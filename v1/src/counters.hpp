@@ -0,0 +1,72 @@
+#ifndef _COUNTERS_HPP_
+#define _COUNTERS_HPP_
+
+#include <cstdint>
+#include <array>
+#include <string>
+
+namespace measure
+{
+    enum counter_event
+    {
+        CYCLES,
+        INSTRUCTIONS,
+        L1D_MISSES,
+        LLC_MISSES,
+        BRANCH_MISSES,
+        N_COUNTER_EVENTS
+    };
+
+    /**
+     * @brief Counts of the events of a span, 0 for the events that could not be opened
+     */
+    struct counter_values
+    {
+        std::array<uint64_t, N_COUNTER_EVENTS> counts{};
+
+        counter_values &operator+=(const counter_values &other)
+        {
+            for (std::size_t i = 0; i < counts.size(); ++i)
+            {
+                counts[i] += other.counts[i];
+            }
+            return *this;
+        }
+    };
+
+    /**
+     * @brief Hardware performance counters of the calling thread (perf_event_open, Linux only), used as the
+     * timer: start() and stop() around a span, then get_values(). The events are opened as a group led by
+     * the cycles, so they count over exactly the same instructions. If the cycles can not be opened (not
+     * Linux, no PMU, perf_event_paranoid) or open is false the counters are not available and count
+     * nothing; the other events are optional. A counters object must be started and stopped on the
+     * thread that created it
+     */
+    class counters
+    {
+    private:
+        std::array<int, N_COUNTER_EVENTS> _fds;
+        counter_values _values;
+
+    public:
+        counters(bool open = true);
+        ~counters();
+
+        counters(const counters &) = delete;
+        counters &operator=(const counters &) = delete;
+
+        bool available() const;
+        bool opened(counter_event event) const;
+
+        void start();
+        void stop();
+        counter_values get_values() const;
+
+        /**
+         * @brief Name of the event in the results, e.g. l1d_misses
+         */
+        static std::string name(counter_event event);
+    };
+}
+
+#endif
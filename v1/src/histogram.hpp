@@ -0,0 +1,158 @@
+#ifndef __HISTOGRAM_HPP__
+#define __HISTOGRAM_HPP__
+
+#include <array>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <nlohmann/json.hpp>
+
+namespace measure
+{
+    /**
+     * @brief Latency histogram of constant size, bucketed as an HDR histogram: every power of two range
+     * is split into 2^sub_bits linear buckets, so a value is recorded within a relative error of 2^-sub_bits
+     * (about 1.6%) from 1 ns up to 2^max_bits ns (about 4.9 hours, larger values are clamped).
+     * The count, sum, min and max are exact
+     */
+    class histogram
+    {
+    private:
+        static constexpr unsigned sub_bits = 6;
+        static constexpr unsigned max_bits = 44;
+        static constexpr uint64_t sub_buckets = uint64_t{1} << sub_bits;
+
+        std::array<uint64_t, (max_bits - sub_bits + 1) * sub_buckets> counts{};
+        uint64_t n{0};
+        uint64_t min_value{std::numeric_limits<uint64_t>::max()};
+        uint64_t max_value{0};
+        double sum{0};
+
+        static unsigned msb(uint64_t v)
+        {
+            unsigned r = 0;
+            while (v >>= 1)
+            {
+                r++;
+            }
+            return r;
+        }
+
+        /**
+         * @brief Values below 2 * sub_buckets have their own bucket, the larger ones are shifted right
+         * until they are in [sub_buckets, 2 * sub_buckets), one range of sub_buckets buckets per shift
+         */
+        static std::size_t index(uint64_t v)
+        {
+            if (v < 2 * sub_buckets)
+            {
+                return v;
+            }
+
+            const unsigned shift = msb(v) - sub_bits;
+            return shift * sub_buckets + (v >> shift);
+        }
+
+        /**
+         * @brief Middle of the values of a bucket
+         */
+        static uint64_t value(std::size_t i)
+        {
+            if (i < 2 * sub_buckets)
+            {
+                return i;
+            }
+
+            const unsigned shift = i / sub_buckets - 1;
+            const uint64_t lowest = (i - shift * sub_buckets) << shift;
+            return lowest + ((uint64_t{1} << shift) >> 1);
+        }
+
+    public:
+        void record(double ns)
+        {
+            const uint64_t max_recordable = (uint64_t{1} << max_bits) - 1;
+            const uint64_t v = ns > 0 ? std::min<uint64_t>(static_cast<uint64_t>(std::llround(ns)), max_recordable) : 0;
+
+            counts[index(v)]++;
+            n++;
+            sum += ns;
+            min_value = std::min(min_value, v);
+            max_value = std::max(max_value, v);
+        }
+
+        void merge(const histogram &other)
+        {
+            for (std::size_t i = 0; i < counts.size(); ++i)
+            {
+                counts[i] += other.counts[i];
+            }
+            n += other.n;
+            sum += other.sum;
+            min_value = std::min(min_value, other.min_value);
+            max_value = std::max(max_value, other.max_value);
+        }
+
+        uint64_t count() const
+        {
+            return n;
+        }
+
+        double mean() const
+        {
+            return n > 0 ? sum / n : 0;
+        }
+
+        uint64_t min() const
+        {
+            return n > 0 ? min_value : 0;
+        }
+
+        uint64_t max() const
+        {
+            return max_value;
+        }
+
+        /**
+         * @brief The smallest recorded value (within the bucket resolution) not exceeded by a fraction q
+         * of the values, 0 if none is recorded
+         */
+        uint64_t percentile(double q) const
+        {
+            if (n == 0)
+            {
+                return 0;
+            }
+
+            const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * n)));
+            uint64_t seen = 0;
+
+            for (std::size_t i = 0; i < counts.size(); ++i)
+            {
+                seen += counts[i];
+
+                if (seen >= rank)
+                {
+                    return std::clamp(value(i), min_value, max_value);
+                }
+            }
+
+            return max_value;
+        }
+
+        nlohmann::ordered_json to_json() const
+        {
+            return {{"count", count()},
+                    {"mean", mean()},
+                    {"min", min()},
+                    {"p50", percentile(0.5)},
+                    {"p90", percentile(0.9)},
+                    {"p99", percentile(0.99)},
+                    {"p99.9", percentile(0.999)},
+                    {"max", max()}};
+        }
+    };
+}
+
+#endif
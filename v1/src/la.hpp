@@ -5,13 +5,53 @@
 #include <utility>
 #include <tuple>
 #include <cmath>
+#include <algorithm>
+#include "type_details.hpp"
+#include "simd.hpp"
+#include "precise_la.hpp"
+
+// The lattice kernels are kept out of line: once inlined in the fit loops the
+// compiler spills their accumulators around the allocations made there
+#if defined(_MSC_VER)
+#define LA_NOINLINE __declspec(noinline)
+#else
+#define LA_NOINLINE __attribute__((noinline))
+#endif
 
 namespace la
 {
+    namespace simd
+    {
+        /**
+         * @brief Accumulator type of the widening kernels for Acc: the compensated pairs for the double-doubles
+         */
+        template <typename Acc>
+        using kernel_accumulator = std::conditional_t<std::is_same_v<Acc, precise_la::double_double>, compensated, Acc>;
+
+        template <typename Acc>
+        kernel_accumulator<Acc> to_kernel(const Acc &x)
+        {
+            if constexpr (std::is_same_v<Acc, precise_la::double_double>)
+                return {x.hi, x.lo};
+            else
+                return x;
+        }
+
+        // The compensated results of the kernels are not normalized
+        template <typename Acc>
+        Acc from_kernel(const kernel_accumulator<Acc> &x)
+        {
+            if constexpr (std::is_same_v<Acc, precise_la::double_double>)
+                return precise_la::double_double::from_sum(x.result, x.error);
+            else
+                return x;
+        }
+    }
+
     namespace sum
     {
-        template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
-        T sum_basic(T *x, std::size_t N)
+        template <typename T, std::enable_if_t<true == is_real<T>(), bool> = true>
+        T sum_basic(const T *x, std::size_t N)
         {
             T res = 0;
 
@@ -26,20 +66,366 @@ namespace la
 
     namespace prod
     {
-        template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
-        T dot_basic(T *x, T *y, std::size_t N)
+        template <typename T, typename Acc = T, std::enable_if_t<true == is_real<T>(), bool> = true>
+        Acc dot_basic(const T *x, const T *y, std::size_t N)
         {
-            T r = 0;
+            Acc r = 0;
 
             for (std::size_t i = 0; i < N; i++)
             {
-                r += x[i] * y[i];
+                r += static_cast<Acc>(x[i]) * y[i];
             }
 
             return r;
         }
+
+        /**
+         * @brief Dot product accumulated in Acc with the SIMD kernels in use for doubles and floats, for floats
+         * accumulated in doubles and for doubles accumulated in double-doubles (see la::simd), dot_basic for
+         * the other types
+         */
+        template <typename T, typename Acc = T, std::enable_if_t<true == is_real<T>(), bool> = true>
+        Acc dot(const T *x, const T *y, std::size_t N)
+        {
+            if constexpr (std::is_same_v<T, Acc> && simd::vectorized<T>)
+                return simd::active<T>().dot(x, y, N);
+            else if constexpr (simd::widening_vectorized<T, simd::kernel_accumulator<Acc>>)
+                return simd::from_kernel<Acc>(simd::active_widening<T, simd::kernel_accumulator<Acc>>().dot(x, y, N));
+            else
+                return dot_basic<T, Acc>(x, y, N);
+        }
     }
 
+    // The lattice kernels store the prediction errors as T and compute in Acc (T unless mixed precision):
+    // the updated errors are rounded to T and the reductions are accumulated in Acc from the rounded values
+    namespace lattice
+    {
+        /**
+         * @brief Computes the three reductions of a BURG's iteration in a single sweep.
+         * Returns [sum b[j] * f[j], sum f[j] * f[j], sum b[j] * b[j]]
+         *
+         * @tparam T a float/double/long double type
+         * @tparam Acc the type of the reductions
+         * @param b the backward prediction errors
+         * @param f the forward prediction errors
+         * @param N the number of elements of both arrays
+         * @return [b·f, f·f, b·b]
+         */
+        template <typename T, typename Acc = T, std::enable_if_t<true == is_real<T>(), bool> = true>
+        LA_NOINLINE std::tuple<Acc, Acc, Acc> dot_3_basic(const T *b, const T *f, std::size_t N)
+        {
+            Acc bf = 0, ff = 0, bb = 0;
+
+            for (std::size_t j = 0; j < N; j++)
+            {
+                Acc bj = b[j];
+                Acc fj = f[j];
+
+                bf += bj * fj;
+                ff += fj * fj;
+                bb += bj * bj;
+            }
+
+            return {bf, ff, bb};
+        }
+
+        /**
+         * @brief Applies the reflection k to the prediction errors:
+         * b[j] = b[j] + k * f[j] and f[j] = f[j] + k * b[j]
+         *
+         * @tparam T a float/double/long double type
+         * @param b the backward prediction errors
+         * @param f the forward prediction errors
+         * @param k the reflection coefficient
+         * @param N the number of elements of both arrays
+         */
+        template <typename T, typename Acc = T, std::enable_if_t<true == is_real<T>(), bool> = true>
+        LA_NOINLINE void reflect_basic(T *b, T *f, Acc k, std::size_t N)
+        {
+            for (std::size_t j = 0; j < N; j++)
+            {
+                Acc bj = b[j];
+                Acc fj = f[j];
+
+                b[j] = static_cast<T>(bj + k * fj);
+                f[j] = static_cast<T>(fj + k * bj);
+            }
+        }
+
+        /**
+         * @brief Applies the reflection k like reflect_basic() and, in the same sweep, computes the
+         * numerator reduction of the next order, where f is shifted by one element:
+         * sum b[j - 1] * f[j] for j in [1, N)
+         *
+         * @return the next b·f
+         */
+        template <typename T, typename Acc = T, std::enable_if_t<true == is_real<T>(), bool> = true>
+        LA_NOINLINE Acc reflect_dot_basic(T *b, T *f, Acc k, std::size_t N)
+        {
+            Acc bf = 0;
+
+            if (N == 0)
+            {
+                return bf;
+            }
+
+            // The first element has no predecessor
+            T b_prev = static_cast<T>(b[0] + k * f[0]);
+            f[0] = static_cast<T>(f[0] + k * b[0]);
+            b[0] = b_prev;
+
+            for (std::size_t j = 1; j < N; j++)
+            {
+                Acc bj = b[j];
+                Acc fj = f[j];
+
+                T b_new = static_cast<T>(bj + k * fj);
+                T f_new = static_cast<T>(fj + k * bj);
+
+                b[j] = b_new;
+                f[j] = f_new;
+
+                bf += static_cast<Acc>(b_prev) * f_new;
+
+                b_prev = b_new;
+            }
+
+            return bf;
+        }
+
+        /**
+         * @brief Applies the reflection k like reflect_basic() and, in the same sweep, computes all the
+         * reductions of the next order, where f is shifted by one element:
+         * [sum b[j - 1] * f[j], sum f[j] * f[j], sum b[j - 1] * b[j - 1]] for j in [1, N)
+         *
+         * @return the next [b·f, f·f, b·b]
+         */
+        template <typename T, typename Acc = T, std::enable_if_t<true == is_real<T>(), bool> = true>
+        LA_NOINLINE std::tuple<Acc, Acc, Acc> reflect_dot_3_basic(T *b, T *f, Acc k, std::size_t N)
+        {
+            Acc bf = 0, ff = 0, bb = 0;
+
+            if (N == 0)
+            {
+                return {bf, ff, bb};
+            }
+
+            // The first element has no predecessor
+            T b_prev = static_cast<T>(b[0] + k * f[0]);
+            f[0] = static_cast<T>(f[0] + k * b[0]);
+            b[0] = b_prev;
+
+            for (std::size_t j = 1; j < N; j++)
+            {
+                Acc bj = b[j];
+                Acc fj = f[j];
+
+                T b_new = static_cast<T>(bj + k * fj);
+                T f_new = static_cast<T>(fj + k * bj);
+
+                b[j] = b_new;
+                f[j] = f_new;
+
+                bf += static_cast<Acc>(b_prev) * f_new;
+                ff += static_cast<Acc>(f_new) * f_new;
+                bb += static_cast<Acc>(b_prev) * b_prev;
+
+                b_prev = b_new;
+            }
+
+            return {bf, ff, bb};
+        }
+
+        // Dispatchers: the SIMD kernels in use for doubles and floats, for floats accumulated in doubles and for
+        // doubles accumulated in double-doubles (see la::simd), the basic versions for the other types.
+        // Acc is deduced from k where there is one
+
+        template <typename T, typename Acc = T, std::enable_if_t<true == is_real<T>(), bool> = true>
+        std::tuple<Acc, Acc, Acc> dot_3(const T *b, const T *f, std::size_t N)
+        {
+            if constexpr (std::is_same_v<T, Acc> && simd::vectorized<T>)
+            {
+                auto r = simd::active<T>().dot_3(b, f, N);
+                return {r.bf, r.ff, r.bb};
+            }
+            else if constexpr (simd::widening_vectorized<T, simd::kernel_accumulator<Acc>>)
+            {
+                auto r = simd::active_widening<T, simd::kernel_accumulator<Acc>>().dot_3(b, f, N);
+                return {simd::from_kernel<Acc>(r.bf), simd::from_kernel<Acc>(r.ff), simd::from_kernel<Acc>(r.bb)};
+            }
+            else
+                return dot_3_basic<T, Acc>(b, f, N);
+        }
+
+        template <typename T, typename Acc = T, std::enable_if_t<true == is_real<T>(), bool> = true>
+        void reflect(T *b, T *f, Acc k, std::size_t N)
+        {
+            if constexpr (std::is_same_v<T, Acc> && simd::vectorized<T>)
+                simd::active<T>().reflect(b, f, k, N);
+            else if constexpr (simd::widening_vectorized<T, simd::kernel_accumulator<Acc>>)
+                simd::active_widening<T, simd::kernel_accumulator<Acc>>().reflect(b, f, simd::to_kernel(k), N);
+            else
+                reflect_basic<T, Acc>(b, f, k, N);
+        }
+
+        template <typename T, typename Acc = T, std::enable_if_t<true == is_real<T>(), bool> = true>
+        Acc reflect_dot(T *b, T *f, Acc k, std::size_t N)
+        {
+            if constexpr (std::is_same_v<T, Acc> && simd::vectorized<T>)
+                return simd::active<T>().reflect_dot(b, f, k, N);
+            else if constexpr (simd::widening_vectorized<T, simd::kernel_accumulator<Acc>>)
+                return simd::from_kernel<Acc>(simd::active_widening<T, simd::kernel_accumulator<Acc>>().reflect_dot(b, f, simd::to_kernel(k), N));
+            else
+                return reflect_dot_basic<T, Acc>(b, f, k, N);
+        }
+
+        template <typename T, typename Acc = T, std::enable_if_t<true == is_real<T>(), bool> = true>
+        std::tuple<Acc, Acc, Acc> reflect_dot_3(T *b, T *f, Acc k, std::size_t N)
+        {
+            if constexpr (std::is_same_v<T, Acc> && simd::vectorized<T>)
+            {
+                auto r = simd::active<T>().reflect_dot_3(b, f, k, N);
+                return {r.bf, r.ff, r.bb};
+            }
+            else if constexpr (simd::widening_vectorized<T, simd::kernel_accumulator<Acc>>)
+            {
+                auto r = simd::active_widening<T, simd::kernel_accumulator<Acc>>().reflect_dot_3(b, f, simd::to_kernel(k), N);
+                return {simd::from_kernel<Acc>(r.bf), simd::from_kernel<Acc>(r.ff), simd::from_kernel<Acc>(r.bb)};
+            }
+            else
+                return reflect_dot_3_basic<T, Acc>(b, f, k, N);
+        }
+    }
+
+    // Vertical versions of the lattice kernels, on lanes windows interleaved element by element:
+    // element j of window l is at [j * lanes + l] and every reduction is computed per window
+    namespace batch
+    {
+        /**
+         * @brief Per window dot_3: bf[l], ff[l] and bb[l] of the N elements of each of the lanes windows
+         */
+        template <typename T, std::enable_if_t<true == is_real<T>(), bool> = true>
+        LA_NOINLINE void dot_3_basic(const T *b, const T *f, std::size_t N, std::size_t lanes, T *bf, T *ff, T *bb)
+        {
+            std::fill(bf, bf + lanes, 0);
+            std::fill(ff, ff + lanes, 0);
+            std::fill(bb, bb + lanes, 0);
+
+            for (std::size_t j = 0; j < N; j++)
+            {
+                const T *bj = &b[j * lanes];
+                const T *fj = &f[j * lanes];
+
+                for (std::size_t l = 0; l < lanes; l++)
+                {
+                    bf[l] += bj[l] * fj[l];
+                    ff[l] += fj[l] * fj[l];
+                    bb[l] += bj[l] * bj[l];
+                }
+            }
+        }
+
+        /**
+         * @brief Per window reflect_dot_3, with the reflection k[l] of each window
+         */
+        template <typename T, std::enable_if_t<true == is_real<T>(), bool> = true>
+        LA_NOINLINE void reflect_dot_3_basic(T *b, T *f, const T *k, std::size_t N, std::size_t lanes, T *bf, T *ff, T *bb)
+        {
+            std::fill(bf, bf + lanes, 0);
+            std::fill(ff, ff + lanes, 0);
+            std::fill(bb, bb + lanes, 0);
+
+            if (N == 0)
+            {
+                return;
+            }
+
+            // The first element has no predecessor
+            for (std::size_t l = 0; l < lanes; l++)
+            {
+                T b0 = b[l];
+                b[l] = b0 + k[l] * f[l];
+                f[l] = f[l] + k[l] * b0;
+            }
+
+            for (std::size_t j = 1; j < N; j++)
+            {
+                T *bj = &b[j * lanes];
+                T *fj = &f[j * lanes];
+                const T *b_prev = bj - lanes; // Already updated
+
+                for (std::size_t l = 0; l < lanes; l++)
+                {
+                    T b_old = bj[l];
+                    T f_old = fj[l];
+
+                    T b_new = b_old + k[l] * f_old;
+                    T f_new = f_old + k[l] * b_old;
+
+                    bj[l] = b_new;
+                    fj[l] = f_new;
+
+                    bf[l] += b_prev[l] * f_new;
+                    ff[l] += f_new * f_new;
+                    bb[l] += b_prev[l] * b_prev[l];
+                }
+            }
+        }
+
+        // Dispatchers: the SIMD kernels in use for doubles and floats (see la::simd), the basic versions for the other types
+
+        template <typename T, std::enable_if_t<true == is_real<T>(), bool> = true>
+        void dot_3(const T *b, const T *f, std::size_t N, std::size_t lanes, T *bf, T *ff, T *bb)
+        {
+            if constexpr (simd::vectorized<T>)
+                simd::active<T>().batch_dot_3(b, f, N, lanes, bf, ff, bb);
+            else
+                dot_3_basic(b, f, N, lanes, bf, ff, bb);
+        }
+
+        template <typename T, std::enable_if_t<true == is_real<T>(), bool> = true>
+        void reflect_dot_3(T *b, T *f, const T *k, std::size_t N, std::size_t lanes, T *bf, T *ff, T *bb)
+        {
+            if constexpr (simd::vectorized<T>)
+                simd::active<T>().batch_reflect_dot_3(b, f, k, N, lanes, bf, ff, bb);
+            else
+                reflect_dot_3_basic(b, f, k, N, lanes, bf, ff, bb);
+        }
+    }
+
+    namespace metrics
+    {
+        /**
+         * @brief Every sum of the error metrics of the estimates y of x in a single pass (see simd::basic_error_sums)
+         */
+        template <typename T, std::enable_if_t<true == is_real<T>(), bool> = true>
+        LA_NOINLINE simd::basic_error_sums<T> error_sums_basic(const T *x, const T *y, std::size_t N)
+        {
+            simd::basic_error_sums<T> r{0, 0, 0, 0};
+
+            for (std::size_t j = 0; j < N; j++)
+            {
+                T e = y[j] - x[j];
+                T a = e < 0 ? -e : e;
+
+                r.abs += a;
+                r.sq += e * e;
+                r.max_abs = a > r.max_abs ? a : r.max_abs;
+                r.signal += x[j] * x[j];
+            }
+
+            return r;
+        }
+
+        template <typename T, std::enable_if_t<true == is_real<T>(), bool> = true>
+        simd::basic_error_sums<T> error_sums(const T *x, const T *y, std::size_t N)
+        {
+            if constexpr (simd::vectorized<T>)
+                return simd::active<T>().error_sums(x, y, N);
+            else
+                return error_sums_basic(x, y, N);
+        }
+    }
 }
 
 #endif // __LA_HPP__
\ No newline at end of file
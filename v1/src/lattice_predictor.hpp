@@ -0,0 +1,125 @@
+#ifndef __LATTICE_PREDICTOR_HPP__
+#define __LATTICE_PREDICTOR_HPP__
+
+#include <type_traits>
+#include <vector>
+#include <algorithm>
+#include "type_details.hpp"
+#include "la.hpp"
+
+/**
+ * @brief Predictor of an AR model in lattice form, running straight from the reflection coefficients
+ * (see the k_out of the estimators' fit), so the direct form is never computed.
+ * The state is the backward error of each stage at the last sample: the prediction of the next sample
+ * is the one zeroing the forward error of the last stage, -sum_m k_{m+1} * b_m, a single dot product,
+ * and feeding a sample runs it once through the stages. Both are O(order), allocation free.
+ *
+ * It has the interface of ar_predictor: a whole horizon (predict(predictions, n)) or one sample at
+ * a time (predict() for the next sample, update() to feed the sample that actually came)
+ *
+ * @tparam T a float/double/long double type
+ */
+template <typename T, std::enable_if_t<true == is_real<T>(), bool> = true>
+class lattice_predictor
+{
+private:
+    std::size_t order;
+    std::vector<T> k;       // Reflection coefficients k_1, ..., k_order
+    std::vector<T> b;       // Backward error of orders [0, order) at the last sample
+    std::vector<T> scratch; // Backward errors of the horizon predictions
+
+    /**
+     * @brief Runs the sample x through the stages with the backward errors bs of the previous sample
+     */
+    void push(T *bs, T x) const
+    {
+        T f = x;     // Forward error of the current order
+        T carry = x; // Backward error of the current order
+
+        for (std::size_t m = 0; m < order; ++m)
+        {
+            T bp = bs[m];
+            bs[m] = carry;
+
+            carry = bp + k[m] * f;
+            f = f + k[m] * bp;
+        }
+    }
+
+public:
+    /**
+     * @brief Predictor for models up to max_order
+     */
+    lattice_predictor(const std::size_t max_order) : order{0}, k(max_order), b(max_order), scratch(max_order) {}
+
+    /**
+     * @brief Sets the reflection coefficients ks of the given order (k_1 first) and the history from
+     * the N given samples, zeros before the first one. Only the last order samples are used. O(order^2)
+     */
+    void reset(const T *ks, std::size_t order, const T *samples, std::size_t N)
+    {
+        this->order = order;
+        std::copy(ks, ks + order, k.begin());
+        std::fill(b.begin(), b.begin() + order, 0);
+
+        for (std::size_t n = N - std::min(N, order); n < N; ++n)
+        {
+            push(b.data(), samples[n]);
+        }
+    }
+
+    /**
+     * @brief Replaces the reflection coefficients, of the same order, keeping the history.
+     * The state is the one of the previous coefficients: it converges to the new one in order samples
+     */
+    void set_coefficients(const T *ks)
+    {
+        std::copy(ks, ks + order, k.begin());
+    }
+
+    /**
+     * @brief Feeds the sample that followed the history
+     */
+    void update(T x)
+    {
+        push(b.data(), x);
+    }
+
+    /**
+     * @brief The prediction of the sample following the history
+     */
+    T predict() const
+    {
+        return -la::prod::dot(b.data(), k.data(), order);
+    }
+
+    /**
+     * @brief Predicts the n samples following the history, writing them in predictions.
+     * The history is left as it is. O(n * order)
+     */
+    void predict(T *predictions, std::size_t n)
+    {
+        std::copy(b.begin(), b.begin() + order, scratch.begin());
+
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            predictions[i] = -la::prod::dot(scratch.data(), k.data(), order);
+            push(scratch.data(), predictions[i]);
+        }
+    }
+
+    std::size_t get_order() const
+    {
+        return order;
+    }
+
+    /**
+     * @brief The largest order the predictor can serve
+     */
+    std::size_t max_order() const
+    {
+        return k.size();
+    }
+};
+
+#endif
@@ -0,0 +1,64 @@
+#include "autotune.hpp"
+#include <iostream>
+#include <filesystem>
+
+const std::vector<std::size_t> sizes{512, 1024, 2048, 4096, 8192};
+const std::vector<std::size_t> orders{1, 2, 4, 8, 16, 32, 64, 128};
+
+/**
+ * @brief Measures the selected engines on the window sizes and orders of the benchmark, with every
+ * instruction set the CPU supports (or only the requested one), and writes <output>/profile.json,
+ * to be given to burg-plc with --profile
+ */
+int main(int argc, char *argv[])
+{
+    try
+    {
+        registry::options opts = registry::parse_args(argc, argv);
+        registry::reject_unsupported(opts, "burg-autotune", {"--output", "--list", "--isa"});
+
+        if (opts.list)
+        {
+            for (const auto &name : registry::names())
+            {
+                std::cout << name << std::endl;
+            }
+            return 0;
+        }
+
+        autotune::tune_options tune;
+        tune.sizes = sizes;
+        tune.orders = orders;
+
+        if (!opts.isa.empty())
+        {
+            tune.isas.push_back(la::simd::from_name(opts.isa));
+        }
+        else
+        {
+            for (auto id : {la::simd::isa::SCALAR, la::simd::isa::SSE2, la::simd::isa::AVX2, la::simd::isa::AVX512})
+            {
+                if (la::simd::supported(id))
+                {
+                    tune.isas.push_back(id);
+                }
+            }
+        }
+
+        std::filesystem::create_directories(opts.output);
+
+        autotune::profile prof;
+        autotune::tune(registry::select<float>(opts.engines), tune, prof);
+        autotune::tune(registry::select<double>(opts.engines), tune, prof);
+        autotune::tune(registry::select<long double>(opts.engines), tune, prof);
+
+        const auto path = std::filesystem::path(opts.output) / "profile.json";
+        prof.save(path.string());
+        logger::success("Profile written in " + path.string());
+    }
+    catch (std::exception &e)
+    {
+        logger::error(e.what());
+    }
+    return 0;
+}
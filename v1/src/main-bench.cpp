@@ -0,0 +1,390 @@
+#include "bench.hpp"
+#include "autotune.hpp"
+#include "precise_la.hpp"
+#include "la.hpp"
+#include "burg_streaming.hpp"
+#include "burg_basic.hpp"
+#include "burg_batch.hpp"
+#include "burg_multichannel.hpp"
+#include "ar_predictor.hpp"
+#include "lattice_predictor.hpp"
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <fstream>
+
+const std::vector<std::size_t> sizes{512, 1024, 2048, 4096, 8192};
+const std::vector<std::size_t> orders{1, 2, 4, 8, 16, 32, 64, 128};
+const std::size_t test_size = 128;
+const std::vector<std::size_t> batch_sizes{64, 128, 512};
+const std::vector<std::size_t> batch_orders{1, 2, 4, 8, 16};
+const std::size_t channels = 2;
+
+/**
+ * @brief Prints a summary as a row of the table
+ */
+void print(const bench::summary &s)
+{
+    std::cout << std::left << std::setw(56) << s.name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << s.min << std::setw(12) << s.median << std::setw(12) << s.mean
+              << std::setw(10) << s.stddev << std::setw(12) << s.max << std::endl;
+}
+
+/**
+ * @brief Benchmarks the sum, dot product and error metrics kernels of type T on vectors of every size
+ */
+template <typename T>
+void bench_kernels(nlohmann::ordered_json &results)
+{
+    const std::string type = registry::type_suffix<T>();
+
+    for (auto N : sizes)
+    {
+        const auto x = autotune::synthetic_window<T>(N, 1);
+        const auto y = autotune::synthetic_window<T>(N, 2);
+        const std::string suffix = "<" + type + ">/" + std::to_string(N);
+
+        const std::vector<bench::summary> summaries{
+            bench::run("la::prod::dot_basic" + suffix, [&]
+                       { bench::do_not_optimize(la::prod::dot_basic(x.data(), y.data(), N)); }),
+            bench::run("la::prod::dot" + suffix, [&]
+                       { bench::do_not_optimize(la::prod::dot(x.data(), y.data(), N)); }),
+            bench::run("precise_la::sum::sum_2s" + suffix, [&]
+                       { bench::do_not_optimize(precise_la::sum::sum_2s(x.data(), N)); }),
+            bench::run("precise_la::sum::sum_xblas" + suffix, [&]
+                       { bench::do_not_optimize(precise_la::sum::sum_xblas(x.data(), N)); }),
+            bench::run("precise_la::prod::dot_2" + suffix, [&]
+                       { bench::do_not_optimize(precise_la::prod::dot_2(x.data(), y.data(), N)); }),
+            bench::run("precise_la::prod::dot_xblas" + suffix, [&]
+                       { bench::do_not_optimize(precise_la::prod::dot_xblas(x.data(), y.data(), N)); }),
+            bench::run("precise_la::prod::dot_2_simd" + suffix, [&]
+                       { bench::do_not_optimize(precise_la::prod::dot_2_simd(x.data(), y.data(), N)); }),
+            bench::run("la::metrics::error_sums" + suffix, [&]
+                       { bench::do_not_optimize(la::metrics::error_sums(x.data(), y.data(), N)); }),
+        };
+
+        for (const auto &s : summaries)
+        {
+            print(s);
+            results.push_back(s.to_json());
+        }
+    }
+}
+
+/**
+ * @brief Benchmarks fit and predict of the engines of type T on a synthetic window of every size,
+ * for every order
+ */
+template <typename T>
+void bench_engines(const std::vector<registry::entry<T>> &engines, nlohmann::ordered_json &results)
+{
+    for (const auto &engine : engines)
+    {
+        for (auto N : sizes)
+        {
+            const auto x = autotune::synthetic_window<T>(N, 1);
+            auto model = engine.create(N);
+            burg_workspace<T> ws{N};
+            std::vector<T> predictions(test_size);
+
+            for (auto order : orders)
+            {
+                if (order >= N)
+                {
+                    continue;
+                }
+
+                std::vector<T> a(order + 1);
+                T *a_out = a.data();
+                T err;
+                const std::string suffix = "/" + std::to_string(N) + "/" + std::to_string(order);
+
+                auto fit = bench::run(engine.name + "::fit" + suffix, [&]
+                                      {
+                                          model->fit_orders(x.data(), N, &order, 1, &a_out, &err, ws);
+                                          bench::do_not_optimize(err); });
+                auto predict = bench::run(engine.name + "::predict" + suffix, [&]
+                                          {
+                                              model->predict(x.data(), N, a.data(), order, predictions.data(), test_size, ws);
+                                              bench::do_not_optimize(predictions[test_size - 1]); });
+
+                print(fit);
+                print(predict);
+                results.push_back(fit.to_json());
+                results.push_back(predict.to_json());
+            }
+        }
+    }
+}
+
+/**
+ * @brief Benchmarks burg_streaming of type T with a window of every size, for every order: the update
+ * with a packet of test_size samples and the conversion of its reflection coefficients, which together
+ * replace a fit per packet
+ */
+template <typename T>
+void bench_streaming(nlohmann::ordered_json &results)
+{
+    const std::string type = registry::type_suffix<T>();
+    const auto packet = autotune::synthetic_window<T>(test_size, 2);
+
+    for (auto N : sizes)
+    {
+        const auto x = autotune::synthetic_window<T>(N, 1);
+
+        for (auto order : orders)
+        {
+            if (order >= N)
+            {
+                continue;
+            }
+
+            burg_streaming<T> model{order, N};
+            std::vector<T> a(order + 1);
+            const std::string suffix = "<" + type + ">/" + std::to_string(N) + "/" + std::to_string(order);
+
+            model.update(x.data(), N);
+
+            auto update = bench::run("burg_streaming::update" + suffix, [&]
+                                     {
+                                         model.update(packet.data(), test_size);
+                                         bench::do_not_optimize(model.reflection_coefficients()[order - 1]); });
+            auto coefficients = bench::run("burg_streaming::coefficients" + suffix, [&]
+                                           {
+                                               model.coefficients(a.data());
+                                               bench::do_not_optimize(a[order]); });
+
+            print(update);
+            print(coefficients);
+            results.push_back(update.to_json());
+            results.push_back(coefficients.to_json());
+        }
+    }
+}
+
+/**
+ * @brief Benchmarks burg_batch of type T fitting Lanes short windows at once, for every order up to 16,
+ * against the Lanes single window fit_orders calls of burg_basic it replaces
+ */
+template <typename T, std::size_t Lanes>
+void bench_batch(nlohmann::ordered_json &results)
+{
+    const std::string type = registry::type_suffix<T>();
+
+    for (auto N : batch_sizes)
+    {
+        std::vector<std::vector<T>> x;
+        std::vector<const T *> windows;
+        for (std::size_t l = 0; l < Lanes; ++l)
+        {
+            x.push_back(autotune::synthetic_window<T>(N, l + 1));
+            windows.push_back(x.back().data());
+        }
+
+        burg_batch<T, Lanes> batch{N};
+        burg_basic<T> model{N};
+        burg_workspace<T> ws{N};
+
+        for (auto order : batch_orders)
+        {
+            std::vector<std::vector<T>> a(Lanes, std::vector<T>(order + 1));
+            std::vector<T *> a_out;
+            for (auto &coeffs : a)
+            {
+                a_out.push_back(coeffs.data());
+            }
+            std::vector<T> err(Lanes);
+            const std::string suffix = "<" + type + "," + std::to_string(Lanes) + ">/" + std::to_string(N) + "/" + std::to_string(order);
+
+            auto fit = bench::run("burg_batch::fit" + suffix, [&]
+                                  {
+                                      batch.fit_orders(windows.data(), N, &order, 1, a_out.data(), err.data());
+                                      bench::do_not_optimize(err[Lanes - 1]); });
+            auto single = bench::run("burg_basic::fit_orders" + suffix, [&]
+                                     {
+                                         for (std::size_t l = 0; l < Lanes; ++l)
+                                         {
+                                             model.fit_orders(windows[l], N, &order, 1, &a_out[l], &err[l], ws);
+                                         }
+                                         bench::do_not_optimize(err[Lanes - 1]); });
+
+            print(fit);
+            print(single);
+            results.push_back(fit.to_json());
+            results.push_back(single.to_json());
+        }
+    }
+}
+
+/**
+ * @brief Benchmarks fit and predict of burg_multichannel of type T on an interleaved window of channels
+ * channels of every size, for every order
+ */
+template <typename T>
+void bench_multichannel(nlohmann::ordered_json &results)
+{
+    const std::string type = registry::type_suffix<T>();
+
+    for (auto N : sizes)
+    {
+        std::vector<T> x(N * channels);
+        for (std::size_t c = 0; c < channels; ++c)
+        {
+            const auto channel = autotune::synthetic_window<T>(N, c + 1);
+            for (std::size_t j = 0; j < N; ++j)
+            {
+                x[j * channels + c] = channel[j];
+            }
+        }
+
+        burg_multichannel<T> model{N, channels};
+        std::vector<T> predictions(test_size * channels);
+
+        for (auto order : orders)
+        {
+            if (order >= N)
+            {
+                continue;
+            }
+
+            std::vector<T> a((order + 1) * channels * channels);
+            std::vector<T> err(channels * channels);
+            T *a_out = a.data();
+            T *err_out = err.data();
+            const std::string suffix = "<" + type + ">/" + std::to_string(channels) + "/" + std::to_string(N) + "/" + std::to_string(order);
+
+            auto fit = bench::run("burg_multichannel::fit" + suffix, [&]
+                                  {
+                                      model.fit_orders(x.data(), N, &order, 1, &a_out, &err_out);
+                                      bench::do_not_optimize(err[0]); });
+            auto predict = bench::run("burg_multichannel::predict" + suffix, [&]
+                                      {
+                                          model.predict(x.data(), N, a.data(), order, predictions.data(), test_size);
+                                          bench::do_not_optimize(predictions[test_size * channels - 1]); });
+
+            print(fit);
+            print(predict);
+            results.push_back(fit.to_json());
+            results.push_back(predict.to_json());
+        }
+    }
+}
+
+/**
+ * @brief Benchmarks the horizon of test_size predictions of type T of ar_predictor, from the AR
+ * coefficients, against the one of lattice_predictor, from the reflection coefficients, for every
+ * order of a model fitted on the largest window. Each call sets the model and the history, then predicts
+ */
+template <typename T>
+void bench_predictors(nlohmann::ordered_json &results)
+{
+    const std::string type = registry::type_suffix<T>();
+    const std::size_t N = sizes.back();
+    const auto x = autotune::synthetic_window<T>(N, 1);
+    burg_basic<T> model{N};
+    burg_workspace<T> ws{N};
+    std::vector<T> predictions(test_size);
+
+    for (auto order : orders)
+    {
+        std::vector<T> a(order + 1), k(order);
+        ar_predictor<T> direct{order};
+        lattice_predictor<T> lattice{order};
+        const std::string suffix = "<" + type + ">/" + std::to_string(order);
+
+        model.fit(x.data(), N, order, a.data(), ws, k.data());
+
+        auto ar = bench::run("ar_predictor::predict" + suffix, [&]
+                             {
+                                 direct.reset(a.data(), order, x.data(), N);
+                                 direct.predict(predictions.data(), test_size);
+                                 bench::do_not_optimize(predictions[test_size - 1]); });
+        auto lt = bench::run("lattice_predictor::predict" + suffix, [&]
+                             {
+                                 lattice.reset(k.data(), order, x.data(), N);
+                                 lattice.predict(predictions.data(), test_size);
+                                 bench::do_not_optimize(predictions[test_size - 1]); });
+
+        print(ar);
+        print(lt);
+        results.push_back(ar.to_json());
+        results.push_back(lt.to_json());
+    }
+}
+
+/**
+ * @brief Micro-benchmarks the la/precise_la kernels, the fit/predict of the selected engines, the
+ * predictors, the update of burg_streaming, burg_batch and burg_multichannel over the window sizes and orders
+ * of the benchmark, with the best instruction set of the CPU (or the requested one). Times per call are printed and written in <output>/bench.json
+ */
+int main(int argc, char *argv[])
+{
+    try
+    {
+        registry::options opts = registry::parse_args(argc, argv);
+        registry::reject_unsupported(opts, "burg-bench", {"--output", "--list", "--isa"});
+
+        if (opts.list)
+        {
+            for (const auto &name : registry::names())
+            {
+                std::cout << name << std::endl;
+            }
+            return 0;
+        }
+
+        if (!opts.isa.empty())
+        {
+            la::simd::select(la::simd::from_name(opts.isa));
+        }
+        logger::info(std::string("Using ") + la::simd::active().name + " kernels");
+
+        std::filesystem::create_directories(opts.output);
+
+        std::cout << std::left << std::setw(56) << "benchmark" << std::right << std::setw(12) << "min ns"
+                  << std::setw(12) << "median ns" << std::setw(12) << "mean ns" << std::setw(10) << "stddev"
+                  << std::setw(12) << "max ns" << std::endl;
+
+        nlohmann::ordered_json results = nlohmann::ordered_json::array();
+
+        bench_kernels<float>(results);
+        bench_kernels<double>(results);
+        bench_kernels<long double>(results);
+
+        bench_engines(registry::select<float>(opts.engines), results);
+        bench_engines(registry::select<double>(opts.engines), results);
+        bench_engines(registry::select<long double>(opts.engines), results);
+
+        bench_predictors<float>(results);
+        bench_predictors<double>(results);
+        bench_predictors<long double>(results);
+
+        bench_streaming<float>(results);
+        bench_streaming<double>(results);
+        bench_streaming<long double>(results);
+
+        // One window per lane of an AVX-512 register, the batch kernels are not vectorized for long doubles
+        bench_batch<float, 16>(results);
+        bench_batch<double, 8>(results);
+
+        bench_multichannel<float>(results);
+        bench_multichannel<double>(results);
+        bench_multichannel<long double>(results);
+
+        const auto path = std::filesystem::path(opts.output) / "bench.json";
+        std::ofstream out{path};
+
+        if (!out)
+        {
+            throw std::runtime_error(path.string() + " was not created due to some issues");
+        }
+
+        out << nlohmann::ordered_json{{"isa", la::simd::active().name}, {"results", results}}.dump(2) << std::endl;
+        logger::success("Results written in " + path.string());
+    }
+    catch (std::exception &e)
+    {
+        logger::error(e.what());
+    }
+    return 0;
+}
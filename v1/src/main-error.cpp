@@ -1,96 +1,125 @@
-#include "burg_basic.hpp"
-#include "burg_optimized_den.hpp"
-#include "burg_optimized_den_sqrt.hpp"
-#include "compensated_burg_basic.hpp"
-#include "compensated_burg_optimized_den.hpp"
-#include "compensated_burg_optimized_den_sqrt.hpp"
+#include "registry.hpp"
 #include "utils.hpp"
 #include "statistic.hpp"
 #include "timer.hpp"
 #include <algorithm>
 #include <cstdlib>
 #include <iostream>
+#include <fstream>
 #include <filesystem>
 #include <regex>
+#include <type_traits>
 #include <algorithm>
 #include <nlohmann/json.hpp>
 
 // #define PRINT
-// #define SAVE_FILE
-
-#if defined(USE_DOUBLE)
-using data_type = double;
-#elif defined(USE_LONG_DOUBLE)
-using data_type = long double;
-#else
-using data_type = double;
-#endif
-
-#if defined(BURG_BASIC)
-using ar = burg_basic<data_type>;
-#elif defined(BURG_OPT_DEN)
-using ar = burg_optimized_den<data_type>;
-#elif defined(BURG_OPT_DEN_SQRT)
-using ar = burg_optimized_den_sqrt<data_type>;
-#elif defined(BURG_COMP_BASIC)
-using ar = compensated_burg_basic<data_type>;
-#elif defined(BURG_COMP_OPT_DEN)
-using ar = compensated_burg_optimized_den<data_type>;
-#elif defined(BURG_COMP_OPT_DEN_SQRT)
-using ar = compensated_burg_optimized_den_sqrt<data_type>;
-#else
-using ar = burg_basic<data_type>;
-#endif
-
-int main()
+
+const uint32_t test_size = 128 * 20;
+const std::vector<uint32_t> train_sizes{512, 1024, 2048, 4096, 8192};
+const std::vector<uint32_t> lag_values{1, 2, 4, 8, 16, 32, 64, 128};
+
+/**
+ * @brief Fits every train size/lag combination on a sinewave with the given engine
+ * and writes the predictions and the absolute errors to <output>/<engine>.json
+ */
+template <typename T>
+void run_engine(const registry::entry<T> &engine, const std::string &output)
 {
-    try
+    uint32_t max_train_size = *std::max_element(train_sizes.begin(), train_sizes.end());
+    uint32_t pos = max_train_size; // Have each model predict starting from the same position
+    uint64_t size = max_train_size + test_size;
+
+    // The float sinewave is the double one rounded, so that the errors of the float engines compare with the double ones
+    using S = std::conditional_t<std::is_same_v<T, float>, double, T>;
+    S frequency = 2000;
+    S sample_rate = 44100;
+    std::vector<T> samples(size);
+
+    // Generate sinewave
+    for (uint i = 0; i < size; ++i)
     {
-        uint32_t test_size = 128*20;
-        std::vector<uint32_t> train_sizes{512, 1024, 2048, 4096, 8192};
-        std::vector<uint32_t> lag_values{1, 2, 4, 8, 16, 32, 64, 128};
+        samples[i] = static_cast<T>(std::sin(M_PI * 2 * i / (sample_rate / frequency)));
+    }
 
-        uint32_t max_train_size = *std::max_element(train_sizes.begin(), train_sizes.end());
-        uint32_t pos = max_train_size; // Have each model predict starting from the same position
-        uint64_t size = max_train_size + test_size;
+    nlohmann::ordered_json result = nlohmann::ordered_json::array();
 
-        data_type frequency = 2000;
-        data_type sample_rate = 44100;
-        std::vector<data_type> samples(size);
+    // For each train size
+    for (auto train_size : train_sizes)
+    {
+        auto ar_model = engine.create(train_size);
 
-        // Generate sinewave
-        for (uint i = 0; i < size; ++i)
+        // For each lag value
+        for (auto lag : lag_values)
         {
-            samples[i] = std::sin(M_PI * 2 * i / (sample_rate / frequency));
+            std::vector<T> train_set(samples.begin() + pos - train_size, samples.begin() + pos);
+            std::vector<T> test_set(samples.begin() + pos, samples.begin() + pos + test_size);
+
+            auto [a_coeff, err] = ar_model->fit(train_set, lag);
+            auto predictions = ar_model->predict(train_set, a_coeff, test_size);
+
+            std::vector<T> ar_ae = stats::ae(test_set, predictions);
+
+            result.push_back({{"train_size", train_size},
+                              {"lag", lag},
+                              {"ar_ae", ar_ae},
+                              {"prediction", predictions},
+                              {"max", std::abs(*std::max_element(predictions.begin(), predictions.end(), [](T a, T b)
+                                                                 { return std::abs(a) < std::abs(b); }))}});
         }
+    }
+
+    const auto path = std::filesystem::path(output) / (engine.name + ".json");
+    std::ofstream out{path};
 
-        nlohmann::ordered_json result = nlohmann::ordered_json::array();
+    if (!out)
+    {
+        throw std::runtime_error(path.string() + " was not created due to some issues");
+    }
+
+    out << result.dump() << std::endl;
+}
 
-        // For each train size
-        for (auto train_size : train_sizes)
+int main(int argc, char *argv[])
+{
+    try
+    {
+        registry::options opts = registry::parse_args(argc, argv);
+        registry::reject_unsupported(opts, "burg-error", {"--output", "--list", "--isa"});
+
+        if (opts.list)
         {
-            // For each lag value
-            for (auto lag : lag_values)
+            for (const auto &name : registry::names())
             {
-                std::vector<data_type> train_set(samples.begin() + pos - train_size, samples.begin() + pos);
-                std::vector<data_type> test_set(samples.begin() + pos, samples.begin() + pos + test_size);
+                std::cout << name << std::endl;
+            }
+            return 0;
+        }
 
-                ar ar_model{train_size};
-                auto [a_coeff, err] = ar_model.fit(train_set, lag);
-                auto predictions = ar_model.predict(train_set, a_coeff, test_size);
+        if (!opts.isa.empty())
+        {
+            la::simd::select(la::simd::from_name(opts.isa));
+        }
+        logger::info(std::string("Using ") + la::simd::active().name + " kernels");
 
-                std::vector<data_type> ar_ae = stats::ae(test_set, predictions);
+        std::filesystem::create_directories(opts.output);
 
-                result.push_back({{"train_size", train_size},
-                                  {"lag", lag},
-                                  {"ar_ae", ar_ae},
-                                  {"prediction", predictions},
-                                  {"max", std::abs(*std::max_element(predictions.begin(), predictions.end(), [](data_type a, data_type b)
-                                                                     { return std::abs(a) < std::abs(b); }))}});
-            }
+        for (const auto &engine : registry::select<float>(opts.engines))
+        {
+            logger::info(engine.name);
+            run_engine(engine, opts.output);
         }
 
-        std::cout << result.dump() << std::endl;
+        for (const auto &engine : registry::select<double>(opts.engines))
+        {
+            logger::info(engine.name);
+            run_engine(engine, opts.output);
+        }
+
+        for (const auto &engine : registry::select<long double>(opts.engines))
+        {
+            logger::info(engine.name);
+            run_engine(engine, opts.output);
+        }
     }
     catch (std::exception &e)
     {
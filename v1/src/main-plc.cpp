@@ -0,0 +1,235 @@
+#include "plc.hpp"
+#include "autotune.hpp"
+#include "wav.hpp"
+#include "utils.hpp"
+#include "statistic.hpp"
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <random>
+#include <nlohmann/json.hpp>
+
+const uint32_t packet_size = 128;
+const double loss_rate = 0.1;
+const uint64_t seed = 1; // Of the loss patterns (see stats::counter_rng)
+
+/**
+ * @brief An engine of the driver: an estimator of the registry fitting the model at every burst, or
+ * the streaming model updated with every packet (the estimator then only fits the short histories)
+ */
+template <typename T>
+struct plc_run
+{
+    std::string name;
+    registry::entry<T> estimator;
+    bool streaming;
+};
+
+/**
+ * @brief Streams the first channel of a file through a plc_engine, losing each packet with
+ * probability loss_rate (the same packets for every engine), and returns the timing counters and
+ * the errors of the concealed packets, next to the ones of silence (b0) and of the previous packet (b1)
+ */
+template <typename T>
+nlohmann::ordered_json run_file(const plc_run<T> &run, const std::string &filepath, const std::vector<bool> &lost, const std::vector<T> &samples, uint32_t sample_rate, double reuse)
+{
+    plc_config config;
+    config.packet_size = packet_size;
+    config.sample_rate = sample_rate;
+    config.reuse = run.streaming ? 0 : reuse;
+    config.streaming = run.streaming;
+
+    plc_engine<T> plc{run.estimator, config};
+
+    const std::size_t n_packets = samples.size() / packet_size;
+    std::vector<T> out(packet_size);
+    std::vector<T> silence(packet_size, 0);
+
+    T mae = 0, b0_mae = 0, b1_mae = 0;
+
+    for (std::size_t p = 0; p < n_packets; ++p)
+    {
+        const T *packet = &samples[p * packet_size];
+
+        plc.process(packet, lost[p], out.data());
+
+        if (lost[p])
+        {
+            mae += stats::mae(packet, out.data(), packet_size);
+            b0_mae += stats::mae(packet, silence.data(), packet_size);
+            b1_mae += stats::mae(packet, p > 0 ? packet - packet_size : silence.data(), packet_size);
+        }
+    }
+
+    const auto &s = plc.stats();
+    const T n_lost = std::max<std::size_t>(s.lost, 1);
+
+    return {{"file", filepath},
+            {"sample_rate", sample_rate},
+            {"packets", s.packets},
+            {"lost", s.lost},
+            {"bursts", s.bursts},
+            {"reused", s.reused},
+            {"deadline_misses", s.deadline_misses},
+            {"budget_ns", s.budget_ns},
+            {"max_ns", s.max_ns},
+            {"mean_ns", s.total_ns / std::max<std::size_t>(s.packets, 1)},
+            {"mae", mae / n_lost},
+            {"b0_mae", b0_mae / n_lost},
+            {"b1_mae", b1_mae / n_lost}};
+}
+
+/**
+ * @brief Runs the engines of type T on every file of the dataset, writing <output>/<engine>.json.
+ * The models are reused across the loss bursts if reuse is set (see plc_config). With streaming,
+ * the streaming model is run too, as burg_streaming_<type>
+ */
+template <typename T>
+void run_engines(const std::vector<registry::entry<T>> &estimators, const std::string &output, double reuse, bool streaming)
+{
+    if (estimators.empty())
+    {
+        return;
+    }
+
+    std::vector<plc_run<T>> engines;
+    for (const auto &estimator : estimators)
+    {
+        engines.push_back({estimator.name, estimator, false});
+    }
+
+    if (streaming)
+    {
+        const std::string type = registry::type_suffix<T>();
+        engines.push_back({"burg_streaming_" + type, registry::select<T>({"burg_basic_" + type})[0], true});
+    }
+
+    std::vector<nlohmann::ordered_json> results(engines.size(), nlohmann::ordered_json::array());
+
+    for (const auto &entry : std::filesystem::recursive_directory_iterator("dataset"))
+    {
+        if (!entry.is_regular_file() || utils::string::tolower(entry.path().extension()).compare(".wav") != 0)
+        {
+            continue;
+        }
+
+        const std::string filepath = entry.path();
+        logger::info(filepath);
+
+        wav_file<T> wav{filepath};
+        wav.read_file();
+
+        const std::vector<T> &samples = wav.data_samples[0];
+        const std::size_t n_packets = samples.size() / packet_size;
+
+        // Loss pattern of the file, shared by every engine and data type: drawn from the stream of its path
+        stats::counter_rng rng{seed, filepath};
+        std::bernoulli_distribution loss{loss_rate};
+        std::vector<bool> lost(n_packets);
+        for (std::size_t p = 0; p < n_packets; ++p)
+        {
+            lost[p] = loss(rng);
+        }
+
+        for (std::size_t e = 0; e < engines.size(); ++e)
+        {
+            results[e].push_back(run_file(engines[e], filepath, lost, samples, wav.sample_rate, reuse));
+
+            const auto &r = results[e].back();
+            if (r["deadline_misses"] > 0)
+            {
+                logger::warning(engines[e].name + ": " + r["deadline_misses"].dump() + " of " + r["packets"].dump() + " packets over the " + r["budget_ns"].dump() + " ns budget");
+            }
+        }
+    }
+
+    for (std::size_t e = 0; e < engines.size(); ++e)
+    {
+        const auto path = std::filesystem::path(output) / (engines[e].name + ".json");
+        std::ofstream out{path};
+
+        if (!out)
+        {
+            throw std::runtime_error(path.string() + " was not created due to some issues");
+        }
+
+        out << results[e].dump() << std::endl;
+    }
+}
+
+/**
+ * @brief Runs the engine of type T the profile dispatches to for the default history and order, with
+ * its kernels. Nothing is run if the profile has no engine of type T
+ */
+template <typename T>
+void run_profile(const autotune::profile &prof, const registry::options &opts)
+{
+    if (!prof.covers<T>())
+    {
+        return;
+    }
+
+    const plc_config config;
+    const auto d = prof.select<T>(config.history_size, config.order, opts.max_error);
+
+    la::simd::select(d.isa);
+    logger::info("Profile: " + d.engine.name + " with " + la::simd::name(d.isa) + " kernels");
+
+    run_engines<T>({d.engine}, opts.output, opts.reuse, false);
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        registry::options opts = registry::parse_args(argc, argv);
+        registry::reject_unsupported(opts, "burg-plc", {"--output", "--list", "--isa", "--reuse", "--profile", "--max-error"});
+
+        // The profile chooses the kernels, and the bound only applies to its candidates
+        if (!opts.profile.empty() && !opts.isa.empty())
+        {
+            throw std::runtime_error("--isa can not be given with --profile, which selects the kernels");
+        }
+        if (opts.profile.empty() && std::find(opts.given.begin(), opts.given.end(), "--max-error") != opts.given.end())
+        {
+            throw std::runtime_error("--max-error requires --profile");
+        }
+
+        if (opts.list)
+        {
+            for (const auto &name : registry::names())
+            {
+                std::cout << name << std::endl;
+            }
+            return 0;
+        }
+
+        if (!opts.isa.empty())
+        {
+            la::simd::select(la::simd::from_name(opts.isa));
+        }
+        logger::info(std::string("Using ") + la::simd::active().name + " kernels");
+
+        std::filesystem::create_directories(opts.output);
+
+        if (!opts.profile.empty())
+        {
+            const auto prof = autotune::profile::load(opts.profile);
+
+            run_profile<float>(prof, opts);
+            run_profile<double>(prof, opts);
+            run_profile<long double>(prof, opts);
+            return 0;
+        }
+
+        run_engines(registry::select<float>(opts.engines), opts.output, opts.reuse, true);
+        run_engines(registry::select<double>(opts.engines), opts.output, opts.reuse, true);
+        run_engines(registry::select<long double>(opts.engines), opts.output, opts.reuse, true);
+    }
+    catch (std::exception &e)
+    {
+        logger::error(e.what());
+    }
+    return 0;
+}
@@ -1,239 +1,983 @@
-#include "burg_basic.hpp"
-#include "burg_optimized_den.hpp"
-#include "burg_optimized_den_sqrt.hpp"
-#include "compensated_burg_basic.hpp"
-#include "compensated_burg_optimized_den.hpp"
-#include "compensated_burg_optimized_den_sqrt.hpp"
+#include "registry.hpp"
+#include "burg_multichannel.hpp"
+#include "model_cache.hpp"
 #include "timer.hpp"
+#include "counters.hpp"
+#include "histogram.hpp"
 #include "wav.hpp"
 #include "utils.hpp"
 #include "statistic.hpp"
-#include "timer.hpp"
+#include "thread_pool.hpp"
 #include <algorithm>
 #include <cstdlib>
 #include <iostream>
+#include <fstream>
 #include <filesystem>
+#include <memory>
+#include <deque>
+#include <mutex>
 #include <regex>
 #include <nlohmann/json.hpp>
 
 // #define PRINT
 // #define SAVE_FILE
 
-#if defined(USE_DOUBLE)
-using data_type = double;
-#define TYPE_NAME "double"
-#elif defined(USE_LONG_DOUBLE)
-using data_type = long double;
-#define TYPE_NAME "long_double"
-#else
-using data_type = double;
-#define TYPE_NAME "double"
-#endif
+const uint32_t test_size = 128;
+const std::vector<uint32_t> train_sizes{512, 1024, 2048, 4096, 8192};
+const std::vector<uint32_t> lag_values{1, 2, 4, 8, 16, 32, 64, 128};
+const uint32_t num_positions = 100;
+const std::vector<std::size_t> orders(lag_values.begin(), lag_values.end());
+const uint32_t positions_per_task = 10;
+const uint64_t seed = 1; // Of the positions, drawn from a stream per file (see stats::counter_rng)
 
-#if defined(BURG_BASIC)
-using ar = burg_basic<data_type>;
-#define NAME "burg_basic"
-#elif defined(BURG_OPT_DEN)
-using ar = burg_optimized_den<data_type>;
-#define NAME "burg_optimized_den"
-#elif defined(BURG_OPT_DEN_SQRT)
-using ar = burg_optimized_den_sqrt<data_type>;
-#define NAME "burg_optimized_den_sqrt"
-#elif defined(BURG_COMP_BASIC)
-using ar = compensated_burg_basic<data_type>;
-#define NAME "compensated_burg_basic"
-#elif defined(BURG_COMP_OPT_DEN)
-using ar = compensated_burg_optimized_den<data_type>;
-#define NAME "compensated_burg_optimized_den"
-#elif defined(BURG_COMP_OPT_DEN_SQRT)
-using ar = compensated_burg_optimized_den_sqrt<data_type>;
-#define NAME "compensated_burg_optimized_den_sqrt"
-#else
-using ar = burg_basic<data_type>;
-#define NAME "burg_basic"
+#ifdef SAVE_FILE
+const uint32_t selected_train_size = 2048;
+const uint32_t selected_lag_value = 128;
 #endif
 
-#define DIR_NAME(x) (x "-" NAME "_" TYPE_NAME)
+/**
+ * @brief Latency histograms of an engine for a train size, over the positions (the times of the
+ * channels in use are summed): the single pass fitting every lag value, the fit of the selected order
+ * model if any, and the predict of each lag value, then of the selected order model if any
+ */
+struct latency
+{
+    measure::histogram fit;
+    measure::histogram fit_selected;
+    std::vector<measure::histogram> predict;
+
+    latency(std::size_t slots = 0) : predict(slots) {}
 
-int main()
+    void merge(const latency &other)
+    {
+        fit.merge(other.fit);
+        fit_selected.merge(other.fit_selected);
+        for (std::size_t l = 0; l < predict.size(); ++l)
+        {
+            predict[l].merge(other.predict[l]);
+        }
+    }
+};
+
+/**
+ * @brief Latency histograms of an engine per train size, over every position of every file.
+ * Each task records into its own histograms and merges them once completed, so the memory does
+ * not grow with the files
+ */
+struct latency_log
 {
-    try
+    std::mutex lock;
+    std::vector<latency> latencies;
+
+    latency_log(std::size_t slots) : latencies(train_sizes.size(), latency{slots}) {}
+
+    void merge(std::size_t t, const latency &l)
     {
-        uint32_t test_size = 128;
-        std::vector<uint32_t> train_sizes{512, 1024, 2048, 4096, 8192};
-        std::vector<uint32_t> lag_values{1, 2 , 4, 8, 16, 32, 64, 128};
-        uint32_t num_positions = 100;
+        std::lock_guard<std::mutex> guard{lock};
+        latencies[t].merge(l);
+    }
+};
+
+/**
+ * @brief State of one of the selected engines across the whole run
+ */
+template <typename T>
+struct engine_run
+{
+    registry::entry<T> engine;
+    std::ofstream out;
+    bool multichannel{false}; // The channels are fitted jointly by burg_multichannel, engine.create is not used
+    std::unique_ptr<latency_log> log;
+};
+
+/**
+ * @brief Results of an engine for a train size and a lag value, one slot per position.
+ * The times of every position are only kept if they are written (raw_times), and the counters
+ * only if they are recorded
+ */
+template <typename T>
+struct lag_results
+{
+    std::vector<T> mae;
+    std::vector<T> rmse;
+    std::vector<T> err;
+    std::vector<double> fit_time;
+    std::vector<double> predict_time;
+    std::vector<uint8_t> reused;    // Channels whose models were served by the cache instead of fitted
+    std::vector<std::size_t> order; // Order of the model of the first channel, for the selected order model
+    std::vector<measure::counter_values> fit_counters; // Only with the hardware performance counters
+    std::vector<measure::counter_values> predict_counters;
+
+    lag_results(bool raw_times, bool counted) : mae(num_positions), rmse(num_positions), err(num_positions), fit_time(raw_times ? num_positions : 0), predict_time(raw_times ? num_positions : 0), reused(num_positions), order(num_positions), fit_counters(counted ? num_positions : 0), predict_counters(counted ? num_positions : 0) {}
+};
+
+/**
+ * @brief A file being benchmarked with the engines of type T.
+ * Its tasks write into disjoint slots of the results, which are emitted once they are all completed
+ */
+template <typename T>
+struct file_job
+{
+    std::string filepath;
+    uint64_t index;
+    std::size_t channels;                        // Channels in use: only the first one unless in multichannel mode
+    std::vector<std::vector<T>> channel_samples; // The samples of each channel in use
+    std::vector<T> frames;                       // The same samples, interleaved
+    std::vector<uint64_t> positions;
+    double reuse;                                // Threshold of the model caches, no cache if 0
+    std::string select;                          // Criterion of the selected order model, none if empty
+    std::vector<measure::counter_event> events;  // Hardware performance counters recorded around the timed spans, none if empty
+    bool raw_times;                              // Write the time of every position too, not only the latency histograms
+    nlohmann::ordered_json baselines;
+    std::vector<std::vector<std::vector<lag_results<T>>>> results; // Per engine, train size and lag value, then the selected order model if any
 
 #ifdef SAVE_FILE
-        uint32_t selected_train_size = 2048;
-        uint32_t selected_lag_value = 128; 
+    std::vector<std::vector<std::vector<T>>> processed_samples; // Per engine and channel
+    std::vector<std::vector<T>> processed_samples_silence;
+    std::vector<std::vector<T>> processed_samples_previous;
+    uint32_t sample_rate;
+    sample_type_enum sample_type;
 #endif
 
-        // seed rand
-        stats::initialize_random(1);
+    parallel::task_group tasks;
 
-        uint64_t index{};
+    file_job(parallel::pool &pool) : tasks{pool} {}
+};
 
-        for (const auto &entry : std::filesystem::recursive_directory_iterator("dataset"))
+/**
+ * @brief MAE and RMSE of the interleaved predictions of each lag value (and of the selected order
+ * model, if any) at the position p
+ */
+template <typename T>
+void record_metrics(const file_job<T> &job, std::vector<lag_results<T>> &results, std::size_t p, const std::vector<std::vector<T>> &frame_predictions)
+{
+    const std::size_t n = test_size * job.channels;
+    const T *test_set = job.frames.data() + job.positions[p] * job.channels;
+
+    for (std::size_t l = 0; l < frame_predictions.size(); ++l)
+    {
+        const auto m = stats::metrics(test_set, frame_predictions[l].data(), n);
+
+        results[l].mae[p] = m.mae;
+        results[l].rmse[p] = m.rmse;
+    }
+}
+
+/**
+ * @brief Records the times of the position p into the histograms of the task, and into the results
+ * if they are written (raw_times): the single pass fit time is the fit time of every lag value
+ */
+template <typename T>
+void record_times(const file_job<T> &job, std::vector<lag_results<T>> &results, std::size_t p, latency &task_latency, double fit_time, double fit_selected_time, const std::vector<double> &predict_time)
+{
+    const bool selecting = predict_time.size() > lag_values.size();
+
+    task_latency.fit.record(fit_time);
+    if (selecting)
+    {
+        task_latency.fit_selected.record(fit_selected_time);
+    }
+
+    for (std::size_t l = 0; l < predict_time.size(); ++l)
+    {
+        task_latency.predict[l].record(predict_time[l]);
+
+        if (job.raw_times)
         {
-            if (entry.is_regular_file() && utils::string::tolower(entry.path().extension()).compare(".wav") == 0)
+            results[l].fit_time[p] = l < lag_values.size() ? fit_time : fit_selected_time;
+            results[l].predict_time[p] = predict_time[l];
+        }
+    }
+}
+
+/**
+ * @brief Runs a single channel engine on a block of positions of a file, for a single train size.
+ * Each channel in use is fitted and predicted on its own: the errors and the times are summed over
+ * the channels, the MAE and the RMSE are computed on all the predicted samples.
+ * Each task owns its model and buffers, so the tasks share nothing but the read-only samples.
+ * If reuse is set, the fits go through a model_cache with a stream per channel: the positions of
+ * the block are in increasing order, so a model is reused while the signal does not drift.
+ * If select is set, a model of the order chosen by the criterion up to the largest lag value is
+ * fitted and predicted too, in the slot following the lag values.
+ * The times are recorded into the histograms of the task, merged into the log of the engine at the end
+ */
+template <typename T>
+void process_block(file_job<T> &job, const registry::entry<T> &engine, latency_log &log, std::size_t e, std::size_t t, std::size_t first, std::size_t last)
+{
+    const uint32_t train_size = train_sizes[t];
+    const std::size_t m = job.channels;
+    auto model = engine.create(train_size);
+    model_cache<T> cache{static_cast<T>(job.reuse)};
+
+    burg_workspace<T> ws{train_size};
+    std::vector<std::vector<T>> a_coeffs;
+    std::vector<T *> a_out;
+    std::vector<T> err_out(lag_values.size());
+    std::vector<T> predictions(test_size);
+    std::vector<std::vector<T>> frame_predictions(lag_values.size(), std::vector<T>(test_size * m)); // Per lag value, interleaved
+
+    // Model of selected order
+    const bool selecting = !job.select.empty();
+    order_selection selection;
+    std::vector<T> a_selected(orders.back() + 1);
+
+    if (selecting)
+    {
+        selection.criterion = criterion_from_name(job.select);
+        frame_predictions.emplace_back(test_size * m);
+    }
+
+    for (auto lag : lag_values)
+    {
+        a_coeffs.emplace_back(lag + 1);
+        a_out.push_back(a_coeffs.back().data());
+    }
+
+    auto &results = job.results[e][t];
+    const bool counted = !job.events.empty();
+    measure::tsc_timer ar_timer{};
+    measure::counters ar_counters{counted}; // Around the timer, so that the times are unchanged
+    latency task_latency{frame_predictions.size()};
+    std::vector<double> predict_time(frame_predictions.size());
+
+    // For each position of the block
+    for (std::size_t p = first; p < last; ++p)
+    {
+        const auto pos = job.positions[p];
+        double fit_time = 0;
+        double fit_selected_time = 0;
+
+        std::fill(predict_time.begin(), predict_time.end(), 0);
+        for (std::size_t l = 0; l < frame_predictions.size(); ++l)
+        {
+            results[l].err[p] = 0;
+            if (counted)
             {
-                const std::string filepath = entry.path();
+                results[l].fit_counters[p] = {};
+                results[l].predict_counters[p] = {};
+            }
+        }
+
+        // For each channel
+        for (std::size_t c = 0; c < m; ++c)
+        {
+            // Views on the samples instead of copies
+            const T *train_set = job.channel_samples[c].data() + pos - train_size;
+
+            // A single pass fits the models of every lag value
+            bool reused = false;
+            ar_counters.start();
+            ar_timer.start();
+            if (job.reuse > 0)
+            {
+                reused = cache.fit_orders(*model, c, pos, train_set, train_size, orders.data(), orders.size(), a_out.data(), err_out.data(), ws);
+            }
+            else
+            {
+                model->fit_orders(train_set, train_size, orders.data(), orders.size(), a_out.data(), err_out.data(), ws);
+            }
+            ar_timer.stop();
+            ar_counters.stop();
+
+            fit_time += ar_timer.get_duration_in_ns();
+            const auto fit_counters = ar_counters.get_values();
+
+            // For each lag value
+            for (std::size_t l = 0; l < lag_values.size(); ++l)
+            {
+                results[l].err[p] += err_out[l];
+                results[l].reused[p] += reused;
+
+                ar_counters.start();
+                ar_timer.start();
+                model->predict(train_set, train_size, a_out[l], lag_values[l], predictions.data(), test_size, ws);
+                ar_timer.stop();
+                ar_counters.stop();
+
+                predict_time[l] += ar_timer.get_duration_in_ns();
+
+                if (counted)
+                {
+                    results[l].fit_counters[p] += fit_counters;
+                    results[l].predict_counters[p] += ar_counters.get_values();
+                }
+
+                for (std::size_t i = 0; i < test_size; ++i)
+                {
+                    frame_predictions[l][i * m + c] = predictions[i];
+                }
+
 #ifdef SAVE_FILE
-                std::string processed_filepath = utils::string::change_first_dir(entry.path(), DIR_NAME("dataset-processed"));
+                if (train_size == selected_train_size && lag_values[l] == selected_lag_value)
+                {
+                    std::copy(predictions.begin(), predictions.end(), job.processed_samples[e][c].begin() + pos);
+                }
 #endif
+            }
 
-                logger::info(filepath);
+            if (selecting)
+            {
+                auto &r = results[lag_values.size()];
+                T err;
+
+                ar_counters.start();
+                ar_timer.start();
+                std::size_t order = model->fit_select(train_set, train_size, orders.back(), selection, a_selected.data(), &err, ws);
+                ar_timer.stop();
+                ar_counters.stop();
+
+                r.err[p] += err;
+                fit_selected_time += ar_timer.get_duration_in_ns();
+                r.order[p] = c == 0 ? order : r.order[p];
+                if (counted)
+                {
+                    r.fit_counters[p] += ar_counters.get_values();
+                }
+
+                ar_counters.start();
+                ar_timer.start();
+                model->predict(train_set, train_size, a_selected.data(), order, predictions.data(), test_size, ws);
+                ar_timer.stop();
+                ar_counters.stop();
+
+                predict_time.back() += ar_timer.get_duration_in_ns();
+                if (counted)
+                {
+                    r.predict_counters[p] += ar_counters.get_values();
+                }
+
+                for (std::size_t i = 0; i < test_size; ++i)
+                {
+                    frame_predictions.back()[i * m + c] = predictions[i];
+                }
+            }
+        }
+
+        record_metrics(job, results, p, frame_predictions);
+        record_times(job, results, p, task_latency, fit_time, fit_selected_time, predict_time);
+    }
+
+    log.merge(t, task_latency);
+}
+
+/**
+ * @brief Runs burg_multichannel on a block of positions of a file, for a single train size.
+ * The error is the trace of the forward error covariance, comparable with the summed errors of the
+ * single channel engines
+ */
+template <typename T>
+void process_block_multichannel(file_job<T> &job, latency_log &log, std::size_t e, std::size_t t, std::size_t first, std::size_t last)
+{
+    const uint32_t train_size = train_sizes[t];
+    const std::size_t m = job.channels;
+    burg_multichannel<T> model{train_size, m};
+
+    std::vector<std::vector<T>> a_coeffs;
+    std::vector<T *> a_out;
+    std::vector<std::vector<T>> err_coeffs;
+    std::vector<T *> err_out;
+    std::vector<std::vector<T>> frame_predictions(lag_values.size(), std::vector<T>(test_size * m));
+
+    for (auto lag : lag_values)
+    {
+        a_coeffs.emplace_back((lag + 1) * m * m);
+        a_out.push_back(a_coeffs.back().data());
+        err_coeffs.emplace_back(m * m);
+        err_out.push_back(err_coeffs.back().data());
+    }
+
+    auto &results = job.results[e][t];
+    const bool counted = !job.events.empty();
+    measure::tsc_timer ar_timer{};
+    measure::counters ar_counters{counted};
+    latency task_latency{lag_values.size()};
+    std::vector<double> predict_time(lag_values.size());
+
+    // For each position of the block
+    for (std::size_t p = first; p < last; ++p)
+    {
+        const auto pos = job.positions[p];
+        const T *train_set = job.frames.data() + (pos - train_size) * m;
+
+        // A single pass fits the models of every lag value
+        ar_counters.start();
+        ar_timer.start();
+        model.fit_orders(train_set, train_size, orders.data(), orders.size(), a_out.data(), err_out.data());
+        ar_timer.stop();
+        ar_counters.stop();
 
-                wav_file<data_type> wav{filepath};
-                wav.read_file();
+        const double fit_time = ar_timer.get_duration_in_ns();
+        const auto fit_counters = ar_counters.get_values();
 
-                std::vector<data_type> samples = wav.data_samples[0];
+        // For each lag value
+        for (std::size_t l = 0; l < lag_values.size(); ++l)
+        {
+            T err = 0;
+            for (std::size_t c = 0; c < m; ++c)
+            {
+                err += err_out[l][c * m + c];
+            }
+
+            results[l].err[p] = err;
+
+            ar_counters.start();
+            ar_timer.start();
+            model.predict(train_set, train_size, a_out[l], lag_values[l], frame_predictions[l].data(), test_size);
+            ar_timer.stop();
+            ar_counters.stop();
+
+            predict_time[l] = ar_timer.get_duration_in_ns();
+
+            if (counted)
+            {
+                results[l].fit_counters[p] = fit_counters;
+                results[l].predict_counters[p] = ar_counters.get_values();
+            }
 
 #ifdef SAVE_FILE
-                std::vector<data_type> processed_samples(wav.data_samples[0]);
-                std::vector<data_type> processed_samples_silence(wav.data_samples[0]);
-                std::vector<data_type> processed_samples_previous(wav.data_samples[0]);
+            if (train_size == selected_train_size && lag_values[l] == selected_lag_value)
+            {
+                for (std::size_t c = 0; c < m; ++c)
+                {
+                    for (std::size_t i = 0; i < test_size; ++i)
+                    {
+                        job.processed_samples[e][c][pos + i] = frame_predictions[l][i * m + c];
+                    }
+                }
+            }
 #endif
+        }
 
-                std::vector<uint64_t> positions = stats::get_n_positions<uint64_t>(*std::max_element(train_sizes.begin(), train_sizes.end()), samples.size() - test_size, num_positions, test_size);
+        record_metrics(job, results, p, frame_predictions);
+        record_times(job, results, p, task_latency, fit_time, 0, predict_time);
+    }
 
-#ifdef PRINT
-                logger::info(utils::io::vector_to_string(positions));
+    log.merge(t, task_latency);
+}
+
+/**
+ * @brief Converts the samples of a file, decoded in the type W, to T and computes its baselines, then
+ * submits a task per train size, engine and block of positions, with the options of the command line. Only the first channel is used, unless
+ * multichannel is set. The fitted models are reused through a model_cache if reuse is set, and a model
+ * of selected order is added if select is set (not by burg_multichannel). The counters of the events
+ * are recorded next to the times of fit and predict, if any.
+ * positions is filled on the first call for the file and reused by the following ones. They are drawn
+ * from the stream of the file path, so they do not depend on the order the files are submitted in
+ */
+template <typename T, typename W>
+std::unique_ptr<file_job<T>> submit_file(const std::string &filepath, const wav_file<W> &wav, const std::vector<engine_run<T>> &runs, std::vector<uint64_t> &positions, uint64_t index, const registry::options &opts, const std::vector<measure::counter_event> &events, parallel::pool &pool)
+{
+    auto job = std::make_unique<file_job<T>>(pool);
+    job->filepath = filepath;
+    job->index = index;
+    job->reuse = opts.reuse;
+    job->select = opts.select;
+    job->events = events;
+    job->raw_times = opts.raw_times;
+
+    job->channels = opts.multichannel ? wav.data_samples.size() : 1;
+    for (std::size_t c = 0; c < job->channels; ++c)
+    {
+        job->channel_samples.emplace_back(wav.data_samples[c].begin(), wav.data_samples[c].end());
+    }
+
+#ifdef SAVE_FILE
+    job->sample_rate = wav.sample_rate;
+    job->sample_type = wav.sample_type;
 #endif
-                nlohmann::ordered_json result = {
-                    {"file", filepath},
-                    {"results", std::vector<nlohmann::ordered_json>()},
-                    {"positions", positions},
-                    {"b0", {{"mae", std::vector<data_type>()}, {"rmse", std::vector<data_type>()}}},
-                    {"b1", {{"mae", std::vector<data_type>()}, {"rmse", std::vector<data_type>()}}},
-                };
 
-                // Benchmark loop
-                for (auto pos : positions)
-                {
-                    std::vector<data_type> test_set(samples.begin() + pos, samples.begin() + pos + test_size);
-                    std::vector<data_type> silence(test_size, 0);
-                    std::vector<data_type> previous_packet(samples.begin() + pos - test_size, samples.begin() + pos);
+    const std::size_t m = job->channels;
+    const std::size_t n_samples = job->channel_samples[0].size();
 
-                    // Benchmark 0
-                    data_type b0_mae = stats::mae(test_set, silence);
-                    result["b0"]["mae"].push_back(b0_mae);
+    job->frames.resize(n_samples * m);
+    for (std::size_t c = 0; c < m; ++c)
+    {
+        for (std::size_t i = 0; i < n_samples; ++i)
+        {
+            job->frames[i * m + c] = job->channel_samples[c][i];
+        }
+    }
+    const auto &frames = job->frames;
 
-                    data_type b0_rmse = stats::rmse(test_set, silence);
-                    result["b0"]["rmse"].push_back(b0_rmse);
+    if (positions.empty())
+    {
+        stats::counter_rng rng{seed, filepath};
+        positions = stats::get_n_positions<uint64_t>(*std::max_element(train_sizes.begin(), train_sizes.end()), n_samples - test_size, num_positions, rng, test_size);
+    }
+    job->positions = positions;
+
+#ifdef SAVE_FILE
+    job->processed_samples.assign(runs.size(), job->channel_samples);
+    job->processed_samples_silence = job->channel_samples;
+    job->processed_samples_previous = job->channel_samples;
+#endif
+
+#ifdef PRINT
+    logger::info(utils::io::vector_to_string(positions));
+#endif
+    job->baselines = {
+        {"b0", {{"mae", std::vector<T>()}, {"rmse", std::vector<T>()}}},
+        {"b1", {{"mae", std::vector<T>()}, {"rmse", std::vector<T>()}}},
+    };
+    auto &baselines = job->baselines;
+
+    // Benchmark loop, on views of the interleaved samples of every channel in use
+    const std::vector<T> silence(test_size * m, 0);
+    for (auto pos : positions)
+    {
+        const T *test_set = frames.data() + pos * m;
+        const T *previous_packet = frames.data() + (pos - test_size) * m;
 
-                    // Benchmark 1
-                    data_type b1_mae = stats::mae(test_set, previous_packet);
-                    result["b1"]["mae"].push_back(b1_mae);
+        // Benchmark 0
+        const auto b0 = stats::metrics(test_set, silence.data(), test_size * m);
+        baselines["b0"]["mae"].push_back(b0.mae);
+        baselines["b0"]["rmse"].push_back(b0.rmse);
 
-                    data_type b1_rmse = stats::rmse(test_set, previous_packet);
-                    result["b1"]["rmse"].push_back(b1_rmse);
+        // Benchmark 1
+        const auto b1 = stats::metrics(test_set, previous_packet, test_size * m);
+        baselines["b1"]["mae"].push_back(b1.mae);
+        baselines["b1"]["rmse"].push_back(b1.rmse);
 
 #ifdef SAVE_FILE
-                    std::copy(silence.begin(), silence.end(), processed_samples_silence.begin() + pos);
-                    std::copy(previous_packet.begin(), previous_packet.end(), processed_samples_previous.begin() + pos);
+        for (std::size_t c = 0; c < m; ++c)
+        {
+            auto &channel = job->channel_samples[c];
+
+            std::fill(job->processed_samples_silence[c].begin() + pos, job->processed_samples_silence[c].begin() + pos + test_size, 0);
+            std::copy(channel.begin() + pos - test_size, channel.begin() + pos, job->processed_samples_previous[c].begin() + pos);
+        }
 #endif
+    }
+
+    const lag_results<T> empty{opts.raw_times, !events.empty()};
+    job->results.assign(runs.size(), std::vector<std::vector<lag_results<T>>>(train_sizes.size(), std::vector<lag_results<T>>(lag_values.size() + (opts.select.empty() ? 0 : 1), empty)));
+
+    // The lag values are not split: a single fit_orders pass serves all of them
+    for (std::size_t t = 0; t < train_sizes.size(); ++t)
+    {
+        for (std::size_t e = 0; e < runs.size(); ++e)
+        {
+            for (std::size_t first = 0; first < positions.size(); first += positions_per_task)
+            {
+                const std::size_t last = std::min<std::size_t>(first + positions_per_task, positions.size());
+                file_job<T> *j = job.get();
+                const registry::entry<T> *engine = &runs[e].engine;
+                latency_log *log = runs[e].log.get();
+
+                if (runs[e].multichannel)
+                {
+                    job->tasks.run([j, log, e, t, first, last]
+                                   { process_block_multichannel(*j, *log, e, t, first, last); });
+                }
+                else
+                {
+                    job->tasks.run([j, engine, log, e, t, first, last]
+                                   { process_block(*j, *engine, *log, e, t, first, last); });
                 }
+            }
+        }
+    }
+
+    return job;
+}
 
-                // For each train size
-                for (auto train_size : train_sizes)
+/**
+ * @brief Adds the times of every position to the results ("ar_fit_time" and "ar_predict_time"),
+ * only if raw_times is set
+ */
+template <typename T>
+void add_times(nlohmann::ordered_json &result, bool raw_times, const lag_results<T> &r)
+{
+    if (raw_times)
+    {
+        result["ar_fit_time"] = r.fit_time;
+        result["ar_predict_time"] = r.predict_time;
+    }
+}
+
+/**
+ * @brief Adds the counts of the events, per position, next to the times of fit and predict:
+ * "ar_fit_counters": {"cycles": [...], ...} and "ar_predict_counters". Nothing is added without events
+ */
+template <typename T>
+void add_counters(nlohmann::ordered_json &result, const std::vector<measure::counter_event> &events, const lag_results<T> &r)
+{
+    if (events.empty())
+    {
+        return;
+    }
+
+    nlohmann::ordered_json fit, predict;
+
+    for (auto event : events)
+    {
+        std::vector<uint64_t> fit_counts, predict_counts;
+
+        for (std::size_t p = 0; p < num_positions; ++p)
+        {
+            fit_counts.push_back(r.fit_counters[p].counts[event]);
+            predict_counts.push_back(r.predict_counters[p].counts[event]);
+        }
+
+        fit[measure::counters::name(event)] = fit_counts;
+        predict[measure::counters::name(event)] = predict_counts;
+    }
+
+    result["ar_fit_counters"] = fit;
+    result["ar_predict_counters"] = predict;
+}
+
+/**
+ * @brief Waits for the tasks of a file and writes its results, exactly as a serial run would
+ */
+template <typename T>
+void write_file(file_job<T> &job, std::vector<engine_run<T>> &runs)
+{
+    job.tasks.wait();
+
+    const auto &filepath = job.filepath;
+    const auto index = job.index;
+    const auto &baselines = job.baselines;
+
+    for (std::size_t e = 0; e < runs.size(); ++e)
+    {
+        nlohmann::ordered_json results = nlohmann::ordered_json::array();
+        std::size_t reused = 0;
+
+        for (std::size_t t = 0; t < train_sizes.size(); ++t)
+        {
+            for (std::size_t l = 0; l < lag_values.size(); ++l)
+            {
+                const auto &r = job.results[e][t][l];
+
+                results.push_back({{"train_size", train_sizes[t]},
+                                   {"lag", lag_values[l]},
+                                   {"ar_mae", r.mae},
+                                   {"ar_rmse", r.rmse},
+                                   {"ar_error", r.err},
+                                   {"total_count", num_positions}});
+
+                add_times(results.back(), job.raw_times, r);
+
+                // Only with the model caches, so that the results are otherwise unchanged
+                if (job.reuse > 0)
                 {
-                    // For each lag value
-                    for (auto lag : lag_values)
-                    {
-                        std::vector<data_type> ar_mae;
-                        std::vector<data_type> ar_rmse;
-                        std::vector<data_type> ar_err;
-                        std::vector<double> ar_fit_time;
-                        std::vector<double> ar_predict_time;
-                        measure::timer ar_timer{};
+                    results.back()["ar_reused"] = r.reused;
+                }
 
-                        // For each position
-                        for (auto pos : positions)
-                        {
-                            std::vector<data_type> train_set(samples.begin() + pos - train_size, samples.begin() + pos);
-                            std::vector<data_type> test_set(samples.begin() + pos, samples.begin() + pos + test_size);
+                add_counters(results.back(), job.events, r);
+            }
+
+            if (!job.select.empty() && !runs[e].multichannel)
+            {
+                const auto &r = job.results[e][t][lag_values.size()];
 
-                            ar ar_model{train_size};
-                            ar_timer.start();
-                            auto [a_coeff, err] = ar_model.fit(train_set, lag);
-                            ar_timer.stop();
+                results.push_back({{"train_size", train_sizes[t]},
+                                   {"lag", job.select},
+                                   {"ar_mae", r.mae},
+                                   {"ar_rmse", r.rmse},
+                                   {"ar_error", r.err},
+                                   {"ar_order", r.order},
+                                   {"total_count", num_positions}});
 
-                            ar_err.push_back(err);
-                            ar_fit_time.push_back(ar_timer.get_duration_in_ns());
+                add_times(results.back(), job.raw_times, r);
 
-                            ar_timer.start();
-                            auto predictions = ar_model.predict(train_set, a_coeff, test_size);
-                            ar_timer.stop();
+                add_counters(results.back(), job.events, r);
+            }
+
+            reused += std::count_if(job.results[e][t][0].reused.begin(), job.results[e][t][0].reused.end(), [](uint8_t n)
+                                    { return n > 0; });
+        }
+
+        if (job.reuse > 0 && !runs[e].multichannel)
+        {
+            logger::info(runs[e].engine.name + ": " + std::to_string(reused) + " of " + std::to_string(train_sizes.size() * num_positions) + " fits reused");
+        }
+
+        auto &out = runs[e].out;
+
+        if (index == 0)
+        {
+            out << ",file,results,b0,b1" << std::endl;
+        }
 
-                            ar_predict_time.push_back(ar_timer.get_duration_in_ns());
+        out << index << "," << filepath << ","
+            << "\"" << std::regex_replace(results.dump(), std::regex("\""), "\'") << "\""
+            << ","
+            << "\"" << std::regex_replace(baselines["b0"].dump(), std::regex("\""), "\'") << "\""
+            << ","
+            << "\"" << std::regex_replace(baselines["b1"].dump(), std::regex("\""), "\'") << "\"" << std::endl;
 
 #ifdef SAVE_FILE
-                            if(train_size == selected_train_size && lag == selected_lag_value) {
-                                std::copy(predictions.begin(), predictions.end(), processed_samples.begin() + pos);
-                            }
+        std::string processed_filepath = utils::string::change_first_dir(filepath, "dataset-processed-" + runs[e].engine.name);
+
+        const auto processed_path = std::filesystem::path(processed_filepath);
+        if (!processed_path.parent_path().empty())
+        {
+            std::filesystem::create_directories(processed_path.parent_path());
+        }
+
+        const auto processed_filepath_ar = utils::string::rename_append_suffix(processed_filepath, "ar_" + std::to_string(selected_train_size) + "_" + std::to_string(selected_lag_value));
+        wav_file<T> processed_wav_ar{processed_filepath_ar};
+        processed_wav_ar.write_file(job.processed_samples[e], job.sample_rate, job.sample_type);
+        logger::info(processed_filepath_ar);
+
+        const auto processed_filepath_silence = utils::string::rename_append_suffix(processed_filepath, "silence");
+        wav_file<T> processed_wav_silence{processed_filepath_silence};
+        processed_wav_silence.write_file(job.processed_samples_silence, job.sample_rate, job.sample_type);
+        logger::info(processed_filepath_silence);
+
+        const auto processed_filepath_previous = utils::string::rename_append_suffix(processed_filepath, "previous");
+        wav_file<T> processed_wav_previous{processed_filepath_previous};
+        processed_wav_previous.write_file(job.processed_samples_previous, job.sample_rate, job.sample_type);
+        logger::info(processed_filepath_previous);
 #endif
+    }
+}
+
+/**
+ * @brief Writes the latency histograms of each engine of type T to <output>/latency/<engine>.json:
+ * per train size the single pass fit of every lag value, then the predict of each lag value (and the
+ * fit and the predict of the selected order model, if any)
+ */
+template <typename T>
+void write_latency(const std::vector<engine_run<T>> &runs, const registry::options &opts)
+{
+    const auto dir = std::filesystem::path(opts.output) / "latency";
+
+    for (const auto &run : runs)
+    {
+        nlohmann::ordered_json histograms = nlohmann::ordered_json::array();
+
+        for (std::size_t t = 0; t < train_sizes.size(); ++t)
+        {
+            const auto &h = run.log->latencies[t];
+            nlohmann::ordered_json lags = nlohmann::ordered_json::array();
+
+            for (std::size_t l = 0; l < lag_values.size(); ++l)
+            {
+                lags.push_back({{"lag", lag_values[l]}, {"ar_predict_time", h.predict[l].to_json()}});
+            }
+
+            if (h.predict.size() > lag_values.size())
+            {
+                lags.push_back({{"lag", opts.select}, {"ar_fit_time", h.fit_selected.to_json()}, {"ar_predict_time", h.predict.back().to_json()}});
+            }
 
-                            data_type predictions_mae = stats::mae(test_set, predictions);
-                            ar_mae.push_back(predictions_mae);
-
-                            data_type predictions_rmse = stats::rmse(test_set, predictions);
-                            ar_rmse.push_back(predictions_rmse);
-                        }
-
-                        result["results"].push_back({{"train_size", train_size},
-                                                     {"lag", lag},
-                                                     {"ar_mae", ar_mae},
-                                                     {"ar_rmse", ar_rmse},
-                                                     {"ar_error", ar_err},
-                                                     {"ar_fit_time", ar_fit_time},
-                                                     {"ar_predict_time", ar_predict_time},
-                                                     {"total_count", num_positions}});
+            histograms.push_back({{"train_size", train_sizes[t]}, {"ar_fit_time", h.fit.to_json()}, {"lags", lags}});
+        }
+
+        std::filesystem::create_directories(dir);
+
+        const auto path = dir / (run.engine.name + ".json");
+        std::ofstream out{path};
+
+        if (!out)
+        {
+            throw std::runtime_error(path.string() + " was not created due to some issues");
+        }
+
+        out << histograms.dump(2) << std::endl;
+    }
+}
+
+/**
+ * @brief Opens the <output>/<engine>.csv result file of each selected engine of type T.
+ * In multichannel mode burg_multichannel_<type> is run too, if any engine of type T is selected
+ */
+template <typename T>
+std::vector<engine_run<T>> open_runs(const registry::options &opts)
+{
+    std::vector<engine_run<T>> runs;
+
+    auto open = [&](const registry::entry<T> &engine, bool multichannel)
+    {
+        const auto path = std::filesystem::path(opts.output) / (engine.name + ".csv");
+        std::ofstream out{path};
+
+        if (!out)
+        {
+            throw std::runtime_error(path.string() + " was not created due to some issues");
+        }
+
+        // burg_multichannel has no selected order model
+        const std::size_t slots = lag_values.size() + (opts.select.empty() || multichannel ? 0 : 1);
+
+        runs.push_back({engine, std::move(out), multichannel, std::make_unique<latency_log>(slots)});
+    };
+
+    for (auto &engine : registry::select<T>(opts.engines))
+    {
+        open(engine, false);
+    }
+
+    if (opts.multichannel && !runs.empty())
+    {
+        open({"burg_multichannel_" + registry::type_suffix<T>(), nullptr}, true);
+    }
+
+    return runs;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        registry::options opts = registry::parse_args(argc, argv);
+        registry::reject_unsupported(opts, "burg", {"--output", "--list", "--isa", "--jobs", "--multichannel", "--reuse", "--select", "--counters", "--raw-times"});
+
+        if (opts.list)
+        {
+            for (const auto &name : registry::names())
+            {
+                std::cout << name << std::endl;
+            }
+            return 0;
+        }
+
+        if (!opts.isa.empty())
+        {
+            la::simd::select(la::simd::from_name(opts.isa));
+        }
+        logger::info(std::string("Using ") + la::simd::active().name + " kernels");
+
+        std::filesystem::create_directories(opts.output);
+
+        auto runs_float = open_runs<float>(opts);
+        auto runs_double = open_runs<double>(opts);
+        auto runs_long_double = open_runs<long double>(opts);
+
+        uint64_t index{};
+
+        parallel::pool pool{opts.jobs};
+        logger::info("Using " + std::to_string(pool.size()) + " threads");
+
+        // Calibrated before the first timed span
+        logger::info("Timer resolution of " + std::to_string(measure::tsc_timer::ns_per_tick()) + " ns");
+
+        // Events the counters of this machine can open, none if the counters are not requested or not available
+        std::vector<measure::counter_event> events;
+        if (opts.counters)
+        {
+            measure::counters probe;
+
+            if (probe.available())
+            {
+                for (int i = 0; i < measure::N_COUNTER_EVENTS; ++i)
+                {
+                    if (probe.opened(static_cast<measure::counter_event>(i)))
+                    {
+                        events.push_back(static_cast<measure::counter_event>(i));
+                        logger::info("Recording the " + measure::counters::name(events.back()) + " counter");
                     }
                 }
+            }
+            else
+            {
+                logger::warning("Hardware performance counters not available, only the times are recorded");
+            }
+        }
+
+        // Files whose tasks are running, written in directory order as they are completed.
+        // At most max_in_flight files are kept in memory
+        struct file_jobs
+        {
+            std::unique_ptr<file_job<float>> job_float;
+            std::unique_ptr<file_job<double>> job_double;
+            std::unique_ptr<file_job<long double>> job_long_double;
+        };
+        std::deque<file_jobs> in_flight;
+        const std::size_t max_in_flight = 2 * pool.size();
+
+        auto write_front = [&]
+        {
+            auto &front = in_flight.front();
+
+            if (front.job_float)
+            {
+                write_file(*front.job_float, runs_float);
+            }
 
-                if (index == 0)
+            if (front.job_double)
+            {
+                write_file(*front.job_double, runs_double);
+            }
+
+            if (front.job_long_double)
+            {
+                write_file(*front.job_long_double, runs_long_double);
+            }
+
+            in_flight.pop_front();
+        };
+
+        for (const auto &entry : std::filesystem::recursive_directory_iterator("dataset"))
+        {
+            if (entry.is_regular_file() && utils::string::tolower(entry.path().extension()).compare(".wav") == 0)
+            {
+                const std::string filepath = entry.path();
+
+                logger::info(filepath);
+
+                // The positions are drawn once per file and shared by every engine
+                std::vector<uint64_t> positions;
+                file_jobs jobs;
+
+                // The file is decoded once, in the widest of the selected types, and converted to each of them
+                auto submit = [&](const auto &wav)
                 {
-                    std::cout << ",file,results,b0,b1" << std::endl;
-                }
+                    if (!runs_float.empty())
+                    {
+                        jobs.job_float = submit_file(filepath, wav, runs_float, positions, index, opts, events, pool);
+                    }
 
-                std::cout << index << "," << std::string(result["file"]) << ","
-                          << "\"" << std::regex_replace(result["results"].dump(), std::regex("\""), "\'") << "\""
-                          << ","
-                          << "\"" << std::regex_replace(result["b0"].dump(), std::regex("\""), "\'") << "\""
-                          << ","
-                          << "\"" << std::regex_replace(result["b1"].dump(), std::regex("\""), "\'") << "\"" << std::endl;
-                index++;
+                    if (!runs_double.empty())
+                    {
+                        jobs.job_double = submit_file(filepath, wav, runs_double, positions, index, opts, events, pool);
+                    }
 
-#ifdef SAVE_FILE
-                const auto processed_path = std::filesystem::path(processed_filepath);
-                if (!processed_path.parent_path().empty())
+                    if (!runs_long_double.empty())
+                    {
+                        jobs.job_long_double = submit_file(filepath, wav, runs_long_double, positions, index, opts, events, pool);
+                    }
+                };
+
+                if (!runs_long_double.empty())
+                {
+                    wav_file<long double> wav{filepath};
+                    wav.read_file();
+                    submit(wav);
+                }
+                else
                 {
-                    std::filesystem::create_directories(processed_path.parent_path());
+                    wav_file<double> wav{filepath};
+                    wav.read_file();
+                    submit(wav);
                 }
 
-                const auto processed_filepath_ar = utils::string::rename_append_suffix(processed_filepath, "ar_"+std::to_string(selected_train_size)+"_"+std::to_string(selected_lag_value));
-                wav_file<double> processed_wav_ar{processed_filepath_ar};
-                processed_wav_ar.write_file(std::vector<std::vector<double>>{processed_samples}, wav.sample_rate, wav.sample_type);
-                logger::info(processed_filepath_ar);
+                in_flight.push_back(std::move(jobs));
 
-                const auto processed_filepath_silence = utils::string::rename_append_suffix(processed_filepath, "silence");
-                wav_file<double> processed_wav_silence{processed_filepath_silence};
-                processed_wav_silence.write_file(std::vector<std::vector<double>>{processed_samples_silence}, wav.sample_rate, wav.sample_type);
-                logger::info(processed_filepath_silence);
+                while (in_flight.size() > max_in_flight)
+                {
+                    write_front();
+                }
 
-                const auto processed_filepath_previous = utils::string::rename_append_suffix(processed_filepath, "previous");
-                wav_file<double> processed_wav_previous{processed_filepath_previous};
-                processed_wav_previous.write_file(std::vector<std::vector<double>>{processed_samples_previous}, wav.sample_rate, wav.sample_type);
-                logger::info(processed_filepath_previous);
-#endif
+                index++;
             }
         }
+
+        while (!in_flight.empty())
+        {
+            write_front();
+        }
+
+        write_latency(runs_float, opts);
+        write_latency(runs_double, opts);
+        write_latency(runs_long_double, opts);
     }
     catch (std::exception &e)
     {
         logger::error(e.what());
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,177 @@
+#ifndef __MODEL_CACHE_HPP__
+#define __MODEL_CACHE_HPP__
+
+#include <type_traits>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include "type_details.hpp"
+#include "registry.hpp"
+
+/**
+ * @brief Counters of a model_cache
+ */
+struct model_cache_stats
+{
+    std::size_t hits{0};   // Requests served by a cached model
+    std::size_t misses{0}; // Requests that ran a full fit
+};
+
+/**
+ * @brief Reuses the models fitted on a stream while its statistics do not change.
+ * A model is cached per stream together with the end of the window it was fitted on (in samples since
+ * the beginning of the stream) and its normalized error, err / energy of the window. When the window
+ * moves forward, the residual of the cached highest order model on the samples that came since the fit
+ * (the last max_probe of them, among the trusted ones) is compared with it: as long as it has not grown by more than the
+ * threshold, the cached models are returned, otherwise the window is fitted again. The comparison is
+ * relative to the fit, not to the previous request, so the drift does not pile up.
+ * The probe costs O(probe * order) against the O(N * order) of the fit.
+ *
+ * Nothing is allocated once every stream has been fitted once
+ *
+ * @tparam T a float/double/long double type
+ */
+template <typename T, std::enable_if_t<true == is_real<T>(), bool> = true>
+class model_cache
+{
+private:
+    struct slot
+    {
+        std::vector<std::size_t> orders;
+        std::vector<std::vector<T>> a; // AR coefficients of each order
+        std::vector<T> err;            // Error of each order
+        std::vector<T> reversed;       // AR coefficients of the highest order, a[order] first
+        uint64_t end;                  // End of the window the models were fitted on
+        std::size_t N;                 // Size of the window
+        T ratio;                       // Normalized error of the highest order
+        T power;                       // Energy per sample of the window
+    };
+
+    std::unordered_map<uint64_t, slot> slots;
+    T threshold;
+    std::size_t max_probe;
+    model_cache_stats s;
+
+    /**
+     * @brief Whether the cached models still describe the window of N samples ending at end, probed on
+     * its last trusted samples only (the probed samples and their regressors)
+     */
+    bool valid(const slot &c, uint64_t end, const T *samples, std::size_t N, const std::size_t *orders, std::size_t n_orders, std::size_t trusted) const
+    {
+        if (c.N != N || end < c.end || !std::equal(orders, orders + n_orders, c.orders.begin(), c.orders.end()))
+        {
+            return false;
+        }
+
+        const std::size_t order = c.reversed.size() - 1;
+        const std::size_t fresh = std::min<uint64_t>(end - c.end, max_probe);
+        std::size_t first = std::max(order, N - std::min(N, fresh));
+
+        if (trusted < N)
+        {
+            first = std::max(first, N - trusted + order);
+        }
+
+        if (first >= N)
+        {
+            return end == c.end;
+        }
+
+        T residual = 0, energy = 0;
+        for (std::size_t n = first; n < N; ++n)
+        {
+            T e = la::prod::dot(&samples[n - order], c.reversed.data(), order + 1);
+
+            residual += e * e;
+            energy += samples[n] * samples[n];
+        }
+
+        // The level has to hold too: a model fitted on noise has a normalized error close to 1, which
+        // any signal would match
+        const T power = energy / (N - first);
+
+        return residual <= (1 + threshold) * c.ratio * energy && power <= (1 + threshold) * c.power && c.power <= (1 + threshold) * power;
+    }
+
+public:
+    /**
+     * @brief Cache tolerating a relative growth of the normalized residual up to threshold,
+     * probed on at most max_probe samples
+     */
+    model_cache(const T threshold, const std::size_t max_probe = 256) : threshold{threshold}, max_probe{max_probe} {}
+
+    /**
+     * @brief fit_orders of the engine (see the BURG's estimators) on the window of N samples ending at
+     * end in the given stream, served by the cached models of the stream if they are still valid.
+     * Only the last trusted samples of the window are probed, e.g. the received ones when the others
+     * were predicted: a model always matches its own predictions. a_out and err_out are written in both cases
+     *
+     * @return whether the cached models were used
+     */
+    bool fit_orders(const ar_engine<T> &engine, uint64_t stream, uint64_t end, const T *samples, std::size_t N, const std::size_t *orders, std::size_t n_orders, T *const *a_out, T *err_out, burg_workspace<T> &ws, std::size_t trusted = std::numeric_limits<std::size_t>::max())
+    {
+        auto it = slots.find(stream);
+
+        if (it != slots.end() && valid(it->second, end, samples, N, orders, n_orders, trusted))
+        {
+            const slot &c = it->second;
+
+            for (std::size_t k = 0; k < n_orders; ++k)
+            {
+                std::copy(c.a[k].begin(), c.a[k].end(), a_out[k]);
+                err_out[k] = c.err[k];
+            }
+
+            s.hits++;
+            return true;
+        }
+
+        engine.fit_orders(samples, N, orders, n_orders, a_out, err_out, ws);
+        s.misses++;
+
+        slot &c = it != slots.end() ? it->second : slots[stream];
+        const std::size_t highest = std::max_element(orders, orders + n_orders) - orders;
+        const std::size_t max_order = std::min(N, ws.size()) - 1; // As clamped by the estimators
+        const std::size_t order = std::min(orders[highest], max_order);
+
+        c.orders.assign(orders, orders + n_orders);
+        c.a.resize(n_orders);
+        c.err.assign(err_out, err_out + n_orders);
+        for (std::size_t k = 0; k < n_orders; ++k)
+        {
+            c.a[k].assign(a_out[k], a_out[k] + std::min(orders[k], max_order) + 1);
+        }
+
+        c.reversed.resize(order + 1);
+        for (std::size_t j = 0; j <= order; ++j)
+        {
+            c.reversed[j] = a_out[highest][order - j];
+        }
+
+        T energy = la::prod::dot(samples, samples, N);
+
+        c.end = end;
+        c.N = N;
+        c.ratio = energy > 0 ? err_out[highest] / energy : 0;
+        c.power = energy / N;
+
+        return false;
+    }
+
+    /**
+     * @brief Forgets the models of every stream
+     */
+    void clear()
+    {
+        slots.clear();
+    }
+
+    const model_cache_stats &stats() const
+    {
+        return s;
+    }
+};
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef __ORDER_SELECTION_HPP__
+#define __ORDER_SELECTION_HPP__
+
+#include <string>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <stdexcept>
+
+/**
+ * @brief Criteria choosing the order of an AR model from the error of each order, err_p, over N samples.
+ * With P_p = err_p / N the prediction error power:
+ * - aic:   N ln(P_p) + 2p (Akaike's information criterion)
+ * - fpe:   P_p (N + p + 1) / (N - p - 1) (Akaike's final prediction error)
+ * - mdl:   N ln(P_p) + p ln(N) (Rissanen's minimum description length)
+ * - cat:   1/N sum_{j <= p} 1/P'_j - 1/P'_p, P'_j = N / (N - j) P_j (Parzen's criterion autoregressive transfer)
+ * - stall: the error itself, an order counting as an improvement only if it reduces the error of the best
+ *          one by more than the tolerance
+ */
+enum class order_criterion
+{
+    aic,
+    fpe,
+    mdl,
+    cat,
+    stall
+};
+
+/**
+ * @brief How the estimators select the order of a model (see their fit_select)
+ */
+struct order_selection
+{
+    order_criterion criterion{order_criterion::aic};
+    std::size_t patience{8}; // Orders without improvement after which the recursion stops (never if 0)
+    double tolerance{1e-3};  // Smallest relative error reduction improving the model (stall only)
+};
+
+inline order_criterion criterion_from_name(const std::string &name)
+{
+    if (name == "aic") return order_criterion::aic;
+    if (name == "fpe") return order_criterion::fpe;
+    if (name == "mdl") return order_criterion::mdl;
+    if (name == "cat") return order_criterion::cat;
+    if (name == "stall") return order_criterion::stall;
+
+    throw std::runtime_error("unknown order criterion " + name);
+}
+
+inline std::string criterion_name(order_criterion criterion)
+{
+    switch (criterion)
+    {
+    case order_criterion::aic: return "aic";
+    case order_criterion::fpe: return "fpe";
+    case order_criterion::mdl: return "mdl";
+    case order_criterion::cat: return "cat";
+    case order_criterion::stall: return "stall";
+    }
+
+    return "";
+}
+
+/**
+ * @brief Tracks the criterion along the order recursion of an estimator: update() is given the error of
+ * each order, from 0, and tells whether it is the best order so far; stop() tells when the criterion has
+ * not improved for patience orders, so that the recursion can end there instead of at the largest order.
+ * The criteria are evaluated in double whatever the type of the estimator, it is only a comparison
+ */
+class order_selector
+{
+private:
+    order_selection selection;
+    double N;
+    double best_value;
+    std::size_t best;
+    double cat_sum; // sum_{j <= p} 1 / P'_j of cat
+
+    double value(std::size_t order, double err)
+    {
+        const double p = static_cast<double>(order);
+        const double power = std::max(err / N, std::numeric_limits<double>::min());
+
+        switch (selection.criterion)
+        {
+        case order_criterion::aic:
+            return N * std::log(power) + 2 * p;
+        case order_criterion::fpe:
+            return power * (N + p + 1) / (N - p - 1);
+        case order_criterion::mdl:
+            return N * std::log(power) + p * std::log(N);
+        case order_criterion::cat:
+            if (order == 0)
+            {
+                return -(1 + 1 / N);
+            }
+            cat_sum += (N - p) / (N * power);
+            return cat_sum / N - (N - p) / (N * power);
+        case order_criterion::stall:
+            return err;
+        }
+
+        return err;
+    }
+
+public:
+    /**
+     * @brief Selector for a window of N samples
+     */
+    order_selector(const order_selection &selection, std::size_t N) : selection{selection}, N{static_cast<double>(N)}, best_value{std::numeric_limits<double>::infinity()}, best{0}, cat_sum{0} {}
+
+    /**
+     * @brief Feeds the error of the next order
+     *
+     * @return whether order is the best one so far
+     */
+    bool update(std::size_t order, double err)
+    {
+        const double v = value(order, err);
+        const bool improved = order == 0 || (selection.criterion == order_criterion::stall ? v < best_value * (1 - selection.tolerance) : v < best_value);
+
+        if (improved)
+        {
+            best_value = v;
+            best = order;
+        }
+
+        return improved;
+    }
+
+    /**
+     * @brief Whether the recursion can stop after order
+     */
+    bool stop(std::size_t order) const
+    {
+        return selection.patience > 0 && order - best >= selection.patience;
+    }
+
+    std::size_t best_order() const
+    {
+        return best;
+    }
+};
+
+#endif
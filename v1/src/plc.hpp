@@ -0,0 +1,292 @@
+#ifndef __PLC_HPP__
+#define __PLC_HPP__
+
+#include <type_traits>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include "type_details.hpp"
+#include "registry.hpp"
+#include "model_cache.hpp"
+#include "burg_streaming.hpp"
+#include "timer.hpp"
+
+/**
+ * @brief Parameters of a plc_engine
+ */
+struct plc_config
+{
+    std::size_t packet_size{128};   // Samples per packet
+    std::size_t history_size{2048}; // Last samples the model is fitted on
+    std::size_t order{32};          // Order of the AR model
+    std::size_t crossfade{32};      // Samples of the cross-fade from the concealment to the first received packet
+    std::size_t mute_after{4};      // Consecutive concealed packets before fading to silence (never if 0)
+    uint32_t sample_rate{48000};    // Hz
+    double budget{0.5};             // Fraction of the duration of a packet available to process it
+    double reuse{0};                // Residual growth tolerated before refitting the model of a previous burst (see model_cache.hpp), refit at every burst if 0
+    bool streaming{false};          // Track the model packet by packet with burg_streaming instead of fitting it at every burst
+};
+
+/**
+ * @brief Counters of a plc_engine
+ */
+struct plc_stats
+{
+    std::size_t packets{0};         // Processed packets
+    std::size_t lost{0};            // Concealed packets
+    std::size_t bursts{0};          // Loss bursts
+    std::size_t reused{0};          // Loss bursts concealed with the model of a previous one
+    std::size_t deadline_misses{0}; // Packets processed in more than the budget
+    double budget_ns{0};            // Per packet latency budget
+    double max_ns{0};               // Slowest packet
+    double total_ns{0};             // Time spent on all the packets
+};
+
+/**
+ * @brief Real-time packet loss concealment on a mono stream, built on the BURG's estimators.
+ * Packets are processed in order: a received one is passed through, a lost one is replaced by the
+ * prediction of the AR model fitted on the last history_size output samples. The model is fitted at
+ * the first packet of a loss burst and the following lost packets continue its prediction.
+ * The first packet received after a loss is cross-faded from the continuation of the concealment,
+ * so there is no discontinuity; long bursts fade to silence, where the prediction is meaningless.
+ * With reuse set, a burst is concealed with the model of the previous one as long as the residual of
+ * that model on the samples received since has not drifted (see model_cache.hpp), which spares the fit.
+ * Only the received samples are probed, not the concealed ones the model predicted itself.
+ * With streaming set, a burg_streaming over the received samples is updated with every packet instead, and a
+ * burst only converts its reflection coefficients, which moves the cost of the fit out of the lost
+ * packets at the price of the accuracy of the recursive estimate (see burg_streaming.hpp).
+ * It adds no latency.
+ *
+ * Every packet is timed against the budget (a fraction of the packet duration, e.g. 2.67 ms for 128
+ * samples at 48 kHz) and the misses are counted. Nothing is allocated after the construction
+ *
+ * @tparam T a float/double/long double type
+ */
+template <typename T, std::enable_if_t<true == is_real<T>(), bool> = true>
+class plc_engine
+{
+private:
+    plc_config config;
+    std::unique_ptr<ar_engine<T>> model;
+    burg_workspace<T> ws;
+
+    std::vector<T> history; // Last history_size samples, mirrored: history[i] == history[i + history_size]
+    std::size_t head;       // Slot of the next sample, the oldest one once the history is full
+    std::size_t count;      // Samples in the history
+    uint64_t end;           // Samples pushed since the beginning of the stream
+    std::size_t received;   // Received samples at the end of the history, since the last concealed one
+
+    std::vector<T> a;           // AR coefficients of the model in use
+    std::size_t order;          // Order of the model in use, 0 if there is none
+    std::vector<T> concealment; // Prediction of the packet and of the crossfade samples following it
+    std::size_t lost_run;       // Consecutive lost packets up to the current one
+    model_cache<T> cache;       // Model of the previous burst, if reuse is set
+    std::unique_ptr<burg_streaming<T>> tracker; // Model of the received samples updated with every packet, if streaming is set
+
+    plc_stats s;
+    measure::timer timer;
+
+    void push(const T *samples, std::size_t n)
+    {
+        const std::size_t H = config.history_size;
+
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            history[head] = samples[i];
+            history[head + H] = samples[i];
+            head = head + 1 == H ? 0 : head + 1;
+        }
+
+        count = std::min(count + n, H);
+        end += n;
+    }
+
+    /**
+     * @brief Fits the model of the given order on the window, or reuses the one of the previous burst
+     */
+    void fit(const T *window)
+    {
+        T *a_out = a.data();
+        T err;
+
+        if (config.reuse > 0)
+        {
+            // The concealed samples are predictions of the previous model, they can not invalidate it
+            s.reused += cache.fit_orders(*model, 0, end, window, count, &order, 1, &a_out, &err, ws, received);
+        }
+        else
+        {
+            model->fit_orders(window, count, &order, 1, &a_out, &err, ws);
+        }
+    }
+
+    /**
+     * @brief Gain of the concealment after the given number of concealed packets: 1 up to mute_after,
+     * then a linear fade to 0 across a packet
+     */
+    T gain(std::size_t packets, std::size_t i) const
+    {
+        if (config.mute_after == 0 || packets < config.mute_after)
+        {
+            return 1;
+        }
+
+        if (packets > config.mute_after)
+        {
+            return 0;
+        }
+
+        return std::max<T>(0, 1 - static_cast<T>(i) / config.packet_size);
+    }
+
+    void conceal(T *out)
+    {
+        const std::size_t P = config.packet_size;
+        const T *window = &history[head + config.history_size - count];
+
+        if (lost_run == 0)
+        {
+            // Fit at the beginning of the burst, on whatever history there is
+            order = count > 1 ? std::min(config.order, count - 1) : 0;
+            s.bursts++;
+
+            if (tracker && count > config.order)
+            {
+                order = config.order;
+                tracker->coefficients(a.data());
+            }
+            else if (order > 0)
+            {
+                fit(window);
+            }
+        }
+
+        if (order > 0)
+        {
+            model->predict(window, count, a.data(), order, concealment.data(), concealment.size(), ws);
+        }
+        else
+        {
+            std::fill(concealment.begin(), concealment.end(), 0);
+        }
+
+        // The history continues with the prediction, so the next lost packet carries on from it
+        push(concealment.data(), P);
+        received = 0;
+
+        for (std::size_t i = 0; i < concealment.size(); ++i)
+        {
+            concealment[i] *= gain(lost_run, i);
+        }
+        std::copy(concealment.begin(), concealment.begin() + P, out);
+    }
+
+public:
+    /**
+     * @brief Conceals with the estimator of the given registry entry (e.g. burg_basic_double)
+     */
+    plc_engine(const registry::entry<T> &estimator, const plc_config &config) : config{config}, model{estimator.create(config.history_size)}, ws{config.history_size},
+                                                                                history(2 * config.history_size), head{0}, count{0}, end{0}, received{0},
+                                                                                a(config.order + 1), order{0}, concealment(config.packet_size + config.crossfade), lost_run{0}, cache{static_cast<T>(config.reuse)}
+    {
+        if (config.packet_size == 0 || config.order == 0 || config.order >= config.history_size || config.sample_rate == 0)
+        {
+            throw std::runtime_error("invalid packet loss concealment parameters");
+        }
+
+        if (config.crossfade > config.packet_size)
+        {
+            throw std::runtime_error("the cross-fade can not be longer than a packet");
+        }
+
+        if (config.streaming && config.reuse > 0)
+        {
+            throw std::runtime_error("the streaming model can not be reused through the model cache");
+        }
+
+        s.budget_ns = config.budget * 1e9 * config.packet_size / config.sample_rate;
+
+        // Warm up the model on the (silent) history, so that the first loss does not pay for the
+        // first touch of the workspace and of the kernels, nor for the allocation of the cache
+        order = config.order;
+        count = config.history_size;
+        fit(history.data());
+        count = 0;
+        s.reused = 0;
+        model->predict(history.data(), config.history_size, a.data(), order, concealment.data(), concealment.size(), ws);
+        order = 0;
+
+        if (config.streaming)
+        {
+            tracker = std::make_unique<burg_streaming<T>>(config.order, config.history_size);
+        }
+    }
+
+    /**
+     * @brief Processes the next packet of the stream (packet_size samples), writing the samples to play
+     * in out. If lost, packet is not read and may be null
+     *
+     * @return whether the packet was processed within the budget
+     */
+    bool process(const T *packet, bool lost, T *out)
+    {
+        timer.start();
+
+        if (lost)
+        {
+            conceal(out);
+            lost_run++;
+            s.lost++;
+        }
+        else
+        {
+            std::copy(packet, packet + config.packet_size, out);
+
+            // Cross-fade from the continuation of the concealment
+            if (lost_run > 0)
+            {
+                for (std::size_t i = 0; i < config.crossfade; ++i)
+                {
+                    T w = static_cast<T>(i + 1) / (config.crossfade + 1);
+                    out[i] = w * packet[i] + (1 - w) * concealment[config.packet_size + i];
+                }
+            }
+
+            push(packet, config.packet_size);
+            received += config.packet_size;
+
+            // Only the received samples: fed with its own predictions the recursive estimate drifts away
+            if (tracker)
+            {
+                tracker->update(packet, config.packet_size);
+            }
+            lost_run = 0;
+        }
+
+        timer.stop();
+
+        double elapsed = timer.get_duration_in_ns();
+        bool on_time = elapsed <= s.budget_ns;
+
+        s.packets++;
+        s.deadline_misses += on_time ? 0 : 1;
+        s.max_ns = std::max(s.max_ns, elapsed);
+        s.total_ns += elapsed;
+
+        return on_time;
+    }
+
+    const plc_stats &stats() const
+    {
+        return s;
+    }
+
+    const plc_config &get_config() const
+    {
+        return config;
+    }
+};
+
+#endif
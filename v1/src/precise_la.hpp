@@ -5,6 +5,9 @@
 #include <utility>
 #include <tuple>
 #include <cmath>
+#include <limits>
+#include <ostream>
+#include "simd.hpp"
 
 namespace precise_la
 {
@@ -108,7 +111,7 @@ namespace precise_la
          * @return std::pair<T, T>
          */
         template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
-        std::pair<T, T> sum_basic(T *x, std::size_t N)
+        std::pair<T, T> sum_basic(const T *x, std::size_t N)
         {
             T res = 0;
 
@@ -141,7 +144,7 @@ namespace precise_la
          * @return [result, error]
          */
         template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
-        std::pair<T, T> sum_2s(T *x, std::size_t N)
+        std::pair<T, T> sum_2s(const T *x, std::size_t N)
         {
             T _p = x[0];
             T _s = 0;
@@ -178,7 +181,7 @@ namespace precise_la
          * @return [result, error]
          */
         template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
-        std::pair<T, T> sum_xblas(T *x, std::size_t N)
+        std::pair<T, T> sum_xblas(const T *x, std::size_t N)
         {
             T _s = 0;
             T _t = 0;
@@ -212,7 +215,7 @@ namespace precise_la
          * @return [result, error]
          */
         template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
-        std::pair<T, T> sum(T *x, std::size_t N, IMPL impl = IMPL::SUM_2S)
+        std::pair<T, T> sum(const T *x, std::size_t N, IMPL impl = IMPL::SUM_2S)
         {
             switch (impl)
             {
@@ -272,7 +275,7 @@ namespace precise_la
          * @return [result, error]
          */
         template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
-        std::pair<T, T> dot_basic(T *x, T *y, std::size_t N)
+        std::pair<T, T> dot_basic(const T *x, const T *y, std::size_t N)
         {
             T r = 0;
 
@@ -306,7 +309,7 @@ namespace precise_la
          * @return [result, error]
          */
         template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
-        std::pair<T, T> dot_2(T *x, T *y, std::size_t N)
+        std::pair<T, T> dot_2(const T *x, const T *y, std::size_t N)
         {
             auto [_p, _s] = two_product_FMA(x[0], y[0]);
 
@@ -349,7 +352,7 @@ namespace precise_la
          * @return [result, error]
          */
         template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
-        std::pair<T, T> dot_xblas(T *x, T *y, std::size_t N)
+        std::pair<T, T> dot_xblas(const T *x, const T *y, std::size_t N)
         {
             T _s = 0, _t = 0;
 
@@ -367,11 +370,39 @@ namespace precise_la
             return {_s, _t};
         }
 
+        /**
+         * @brief Returns the result of the dot product as a pair [result, error].
+         * It implements the dot_2 algorithm with the la::simd kernels in use for doubles and floats:
+         * every lane runs its own Dot2 and the lanes are then merged with TwoSum, so the accuracy is the
+         * one of dot_2 while the order of the operations depends on the instruction set.
+         * Other types fall back to dot_2
+         *
+         * @tparam T a float/double/long double type
+         * @param x the array with the x elements
+         * @param y the array with the y elements
+         * @param N the size of both arrays (needs to be the same)
+         * @return [result, error]
+         */
+        template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
+        std::pair<T, T> dot_2_simd(const T *x, const T *y, std::size_t N)
+        {
+            if constexpr (la::simd::vectorized<T>)
+            {
+                auto [r, e] = la::simd::active<T>().dot_2(x, y, N);
+                return {r, e};
+            }
+            else
+            {
+                return dot_2(x, y, N);
+            }
+        }
+
         enum IMPL
         {
             DOT_BASIC,
             DOT_2,
-            DOT_XBLAS
+            DOT_XBLAS,
+            DOT_2_SIMD
         };
 
         /**
@@ -386,7 +417,7 @@ namespace precise_la
          * @return [result, error]
          */
         template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
-        std::pair<T, T> dot(T *x, T *y, std::size_t N, IMPL impl = IMPL::DOT_2)
+        std::pair<T, T> dot(const T *x, const T *y, std::size_t N, IMPL impl = IMPL::DOT_2)
         {
             switch (impl)
             {
@@ -396,6 +427,8 @@ namespace precise_la
                 return dot_2(x, y, N);
             case IMPL::DOT_XBLAS:
                 return dot_xblas(x, y, N);
+            case IMPL::DOT_2_SIMD:
+                return dot_2_simd(x, y, N);
             }
 
             return {0, 0};
@@ -443,6 +476,309 @@ namespace precise_la
             return {-a.first, -a.second};
         }
     }
+
+    namespace lattice
+    {
+        /**
+         * @brief Compensated update of the forward and backward errors of a BURG's iteration
+         *
+         * \f[
+         *   function Reflect(b, f, k, N)
+         *                for j = 0:N
+         *                    b[j] = SumPairs([b[j], 0], TwoProductFMA(k, f[j]))
+         *                    f[j] = SumPairs([f[j], 0], TwoProductFMA(k, b[j]))
+         * \f]
+         *
+         * where both updates use the values of b[j] and f[j] before the iteration
+         *
+         * @tparam T a float/double/long double type
+         * @param b the backward errors
+         * @param f the forward errors, already offset by the order
+         * @param k the reflection coefficient
+         * @param N the number of elements to update
+         */
+        template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
+        void reflect_basic(T *b, T *f, T k, std::size_t N)
+        {
+            for (std::size_t j = 0; j < N; j++)
+            {
+                T bj = b[j];
+                T fj = f[j];
+
+                b[j] = utils::sum_pair_elements(utils::sum_pairs({bj, 0}, prod::two_product_FMA(k, fj)));
+                f[j] = utils::sum_pair_elements(utils::sum_pairs({fj, 0}, prod::two_product_FMA(k, bj)));
+            }
+        }
+
+        /**
+         * @brief Same as reflect_basic, with the la::simd kernels in use for doubles and floats.
+         * The updates are element-wise, so every instruction set gives the reflect_basic results
+         */
+        template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
+        void reflect(T *b, T *f, T k, std::size_t N)
+        {
+            if constexpr (la::simd::vectorized<T>)
+            {
+                la::simd::active<T>().reflect_2(b, f, k, N);
+            }
+            else
+            {
+                reflect_basic(b, f, k, N);
+            }
+        }
+    }
+
+    /**
+     * @brief Double-double number: the unevaluated sum hi + lo of two doubles, with |lo| <= ulp(hi) / 2.
+     * It has about 106 bits of significand and the range of a double on every architecture, unlike
+     * long double (a double on some ARM platforms, a software quad on others).
+     * The operations are the ones of the QD library @cite Hida-2001, built on TwoSum and TwoProductFMA,
+     * so they only need double arithmetic, they inline and they vectorize like it.
+     *
+     * It is a drop-in type for the estimators (see is_real), either as T or as their accumulator type
+     */
+    struct double_double
+    {
+        double hi;
+        double lo;
+
+        constexpr double_double() : hi{0}, lo{0} {}
+
+        constexpr double_double(double x) : hi{x}, lo{0} {}
+
+        /**
+         * @brief From a normalized pair, |lo| <= ulp(hi) / 2 (see from_sum() otherwise)
+         */
+        constexpr double_double(double hi, double lo) : hi{hi}, lo{lo} {}
+
+        /**
+         * @brief From any other arithmetic type, exactly if it has at most 106 bits (e.g. long double)
+         */
+        template <typename U, std::enable_if_t<std::is_arithmetic_v<U> && !std::is_same_v<U, double>, bool> = true>
+        constexpr double_double(U x) : hi{static_cast<double>(x)}, lo{static_cast<double>(x - static_cast<U>(static_cast<double>(x)))} {}
+
+        /**
+         * @brief The normalized sum a + b
+         */
+        static double_double from_sum(double a, double b)
+        {
+            auto [s, e] = sum::two_sum(a, b);
+            return {s, e};
+        }
+
+        template <typename U, std::enable_if_t<std::is_arithmetic_v<U>, bool> = true>
+        explicit constexpr operator U() const
+        {
+            return static_cast<U>(hi) + static_cast<U>(lo);
+        }
+
+        double_double &operator+=(const double_double &b);
+        double_double &operator-=(const double_double &b);
+        double_double &operator*=(const double_double &b);
+        double_double &operator/=(const double_double &b);
+    };
+
+    inline double_double operator-(const double_double &a)
+    {
+        return {-a.hi, -a.lo};
+    }
+
+    inline double_double operator+(const double_double &a, const double_double &b)
+    {
+        auto [s, e] = sum::two_sum(a.hi, b.hi);
+        auto [t, f] = sum::two_sum(a.lo, b.lo);
+
+        auto [s1, e1] = sum::fast_two_sum(s, e + t);
+        auto [s2, e2] = sum::fast_two_sum(s1, e1 + f);
+
+        return {s2, e2};
+    }
+
+    inline double_double operator+(const double_double &a, double b)
+    {
+        auto [s, e] = sum::two_sum(a.hi, b);
+        auto [s1, e1] = sum::fast_two_sum(s, e + a.lo);
+
+        return {s1, e1};
+    }
+
+    inline double_double operator+(double a, const double_double &b)
+    {
+        return b + a;
+    }
+
+    inline double_double operator-(const double_double &a, const double_double &b)
+    {
+        return a + (-b);
+    }
+
+    inline double_double operator-(const double_double &a, double b)
+    {
+        return a + (-b);
+    }
+
+    inline double_double operator-(double a, const double_double &b)
+    {
+        return (-b) + a;
+    }
+
+    inline double_double operator*(const double_double &a, const double_double &b)
+    {
+        auto [p, e] = prod::two_product_FMA(a.hi, b.hi);
+        auto [p1, e1] = sum::fast_two_sum(p, e + (a.hi * b.lo + a.lo * b.hi));
+
+        return {p1, e1};
+    }
+
+    inline double_double operator*(const double_double &a, double b)
+    {
+        auto [p, e] = prod::two_product_FMA(a.hi, b);
+        auto [p1, e1] = sum::fast_two_sum(p, e + a.lo * b);
+
+        return {p1, e1};
+    }
+
+    inline double_double operator*(double a, const double_double &b)
+    {
+        return b * a;
+    }
+
+    // Long division, three quotient digits
+    inline double_double operator/(const double_double &a, const double_double &b)
+    {
+        double q1 = a.hi / b.hi;
+        double_double r = a - b * q1;
+
+        double q2 = r.hi / b.hi;
+        r = r - b * q2;
+
+        double q3 = r.hi / b.hi;
+
+        auto [q, e] = sum::fast_two_sum(q1, q2);
+        return double_double{q, e} + q3;
+    }
+
+    inline double_double operator/(const double_double &a, double b)
+    {
+        double q1 = a.hi / b;
+        auto [p, e] = prod::two_product_FMA(q1, b);
+        auto [s, f] = sum::two_sum(a.hi, -p);
+
+        double q2 = (s + ((f - e) + a.lo)) / b;
+
+        auto [q, r] = sum::fast_two_sum(q1, q2);
+        return {q, r};
+    }
+
+    inline double_double operator/(double a, const double_double &b)
+    {
+        return double_double{a} / b;
+    }
+
+    inline double_double &double_double::operator+=(const double_double &b)
+    {
+        return *this = *this + b;
+    }
+
+    inline double_double &double_double::operator-=(const double_double &b)
+    {
+        return *this = *this - b;
+    }
+
+    inline double_double &double_double::operator*=(const double_double &b)
+    {
+        return *this = *this * b;
+    }
+
+    inline double_double &double_double::operator/=(const double_double &b)
+    {
+        return *this = *this / b;
+    }
+
+    inline bool operator==(const double_double &a, const double_double &b)
+    {
+        return a.hi == b.hi && a.lo == b.lo;
+    }
+
+    inline bool operator!=(const double_double &a, const double_double &b)
+    {
+        return !(a == b);
+    }
+
+    inline bool operator<(const double_double &a, const double_double &b)
+    {
+        return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo);
+    }
+
+    inline bool operator>(const double_double &a, const double_double &b)
+    {
+        return b < a;
+    }
+
+    inline bool operator<=(const double_double &a, const double_double &b)
+    {
+        return !(b < a);
+    }
+
+    inline bool operator>=(const double_double &a, const double_double &b)
+    {
+        return !(a < b);
+    }
+
+    inline double_double abs(const double_double &a)
+    {
+        return a.hi < 0 ? -a : a;
+    }
+
+    inline double_double fabs(const double_double &a)
+    {
+        return abs(a);
+    }
+
+    // One Newton step from the double square root
+    inline double_double sqrt(const double_double &a)
+    {
+        if (a.hi <= 0)
+        {
+            return std::sqrt(a.hi);
+        }
+
+        double x = std::sqrt(a.hi);
+        auto [p, e] = prod::two_product_FMA(x, x);
+
+        return double_double{x} + ((a - double_double{p, e}).hi * 0.5 / x);
+    }
+
+    /**
+     * @brief Prints hi, followed by lo if not 0, with the precision of the stream
+     */
+    inline std::ostream &operator<<(std::ostream &os, const double_double &a)
+    {
+        os << a.hi;
+
+        if (a.lo != 0)
+        {
+            os << (a.lo < 0 ? " - " : " + ") << std::abs(a.lo);
+        }
+
+        return os;
+    }
+}
+
+namespace std
+{
+    template <>
+    struct numeric_limits<precise_la::double_double> : public numeric_limits<double>
+    {
+        static constexpr int digits = 106;
+        static constexpr int digits10 = 31;
+        static constexpr int max_digits10 = 33;
+
+        static constexpr precise_la::double_double epsilon() { return 4.93038065763132e-32; } // 2^-104
+        static constexpr precise_la::double_double min() { return 2.0041683600089728e-292; }  // 2^-969, so that lo is normal
+        static constexpr precise_la::double_double max() { return {1.79769313486231570815e+308, 9.97920154767359795037e+291}; }
+        static constexpr precise_la::double_double lowest() { return {-1.79769313486231570815e+308, -9.97920154767359795037e+291}; }
+    };
 }
 
 #endif
\ No newline at end of file
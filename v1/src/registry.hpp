@@ -0,0 +1,454 @@
+#ifndef __REGISTRY_HPP__
+#define __REGISTRY_HPP__
+
+#include <type_traits>
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <cctype>
+#include "burg_basic.hpp"
+#include "burg_optimized_den.hpp"
+#include "burg_optimized_den_sqrt.hpp"
+#include "compensated_burg_basic.hpp"
+#include "compensated_burg_optimized_den.hpp"
+#include "compensated_burg_optimized_den_sqrt.hpp"
+
+/**
+ * @brief Type erased interface of a BURG's AR estimator, so that the drivers can
+ * select the implementation at runtime instead of at compile time
+ *
+ * @tparam T a float/double/long double type
+ */
+template <typename T, std::enable_if_t<true == is_real<T>(), bool> = true>
+class ar_engine
+{
+public:
+    virtual ~ar_engine() = default;
+
+    virtual std::pair<std::vector<T>, T> fit(std::vector<T> &samples, std::size_t order) = 0;
+    virtual std::pair<std::vector<T>, T> fit_reflection(std::vector<T> &samples, std::size_t order) = 0;
+    virtual std::pair<std::vector<T>, T> fit_select(std::vector<T> &samples, std::size_t order, const order_selection &selection) = 0;
+    virtual std::vector<std::pair<std::vector<T>, T>> fit_orders(std::vector<T> &samples, const std::vector<std::size_t> &orders) = 0;
+    virtual std::vector<T> predict(std::vector<T> &samples, std::vector<T> &a, std::size_t n) = 0;
+
+    // Allocation free versions, writing in buffers owned by the caller (see burg_workspace)
+    virtual void fit_orders(const T *samples, std::size_t N, const std::size_t *orders, std::size_t n_orders, T *const *a_out, T *err_out, burg_workspace<T> &ws, T *const *k_out = nullptr) const = 0;
+    virtual std::size_t fit_select(const T *samples, std::size_t N, std::size_t order, const order_selection &selection, T *a_out, T *err_out, burg_workspace<T> &ws, T *k_out = nullptr) const = 0;
+    virtual void predict(const T *samples, std::size_t N, const T *a, std::size_t order, T *predictions, std::size_t n, burg_workspace<T> &ws) const = 0;
+};
+
+/**
+ * @brief Adapter exposing one of the estimator classes through the ar_engine interface
+ *
+ * @tparam AR the estimator class (e.g. burg_basic<T>)
+ * @tparam T a float/double/long double type
+ */
+template <typename AR, typename T>
+class ar_engine_impl : public ar_engine<T>
+{
+private:
+    AR model;
+
+public:
+    ar_engine_impl(const std::size_t max_size) : model{max_size} {}
+
+    std::pair<std::vector<T>, T> fit(std::vector<T> &samples, std::size_t order) override
+    {
+        return model.fit(samples, order);
+    }
+
+    std::pair<std::vector<T>, T> fit_reflection(std::vector<T> &samples, std::size_t order) override
+    {
+        return model.fit_reflection(samples, order);
+    }
+
+    std::pair<std::vector<T>, T> fit_select(std::vector<T> &samples, std::size_t order, const order_selection &selection) override
+    {
+        return model.fit_select(samples, order, selection);
+    }
+
+    std::vector<std::pair<std::vector<T>, T>> fit_orders(std::vector<T> &samples, const std::vector<std::size_t> &orders) override
+    {
+        return model.fit_orders(samples, orders);
+    }
+
+    std::vector<T> predict(std::vector<T> &samples, std::vector<T> &a, std::size_t n) override
+    {
+        return model.predict(samples, a, n);
+    }
+
+    void fit_orders(const T *samples, std::size_t N, const std::size_t *orders, std::size_t n_orders, T *const *a_out, T *err_out, burg_workspace<T> &ws, T *const *k_out = nullptr) const override
+    {
+        model.fit_orders(samples, N, orders, n_orders, a_out, err_out, ws, k_out);
+    }
+
+    std::size_t fit_select(const T *samples, std::size_t N, std::size_t order, const order_selection &selection, T *a_out, T *err_out, burg_workspace<T> &ws, T *k_out = nullptr) const override
+    {
+        return model.fit_select(samples, N, order, selection, a_out, err_out, ws, k_out);
+    }
+
+    void predict(const T *samples, std::size_t N, const T *a, std::size_t order, T *predictions, std::size_t n, burg_workspace<T> &ws) const override
+    {
+        model.predict(samples, N, a, order, predictions, n, ws);
+    }
+};
+
+namespace registry
+{
+    template <typename T>
+    using factory = std::function<std::unique_ptr<ar_engine<T>>(std::size_t)>;
+
+    template <typename T>
+    struct entry
+    {
+        std::string name; // <estimator>_<type>, e.g. burg_basic_double
+        factory<T> create;
+    };
+
+    /**
+     * @brief Name of the data type as used in the engine names and output directories
+     */
+    template <typename T, std::enable_if_t<true == is_real<T>(), bool> = true>
+    const std::string type_suffix()
+    {
+        if constexpr (std::is_same_v<T, float>) return "float";
+        else if constexpr (std::is_same_v<T, double>) return "double";
+        else if constexpr (std::is_same_v<T, long double>) return "long_double";
+        else if constexpr (std::is_same_v<T, precise_la::double_double>) return "double_double";
+        else return "";
+    }
+
+    /**
+     * @brief Accumulator type of the mixed precision engines of T: the next wider type, T if there is none.
+     * double accumulates in double-double, which runs on the SIMD kernels, rather than in long double
+     */
+    template <typename T>
+    struct wider
+    {
+        using type = T;
+    };
+
+    template <>
+    struct wider<float>
+    {
+        using type = double;
+    };
+
+    template <>
+    struct wider<double>
+    {
+        using type = precise_la::double_double;
+    };
+
+    template <typename T>
+    using wider_t = typename wider<T>::type;
+
+    /**
+     * @brief Entry of the estimator AR, named <estimator>_<type> or, if it accumulates in a
+     * different type, <estimator>_<type>_acc_<accumulator type> (e.g. burg_basic_float_acc_double).
+     * The separator keeps the name unambiguous, since a type name may contain underscores
+     */
+    template <typename AR, typename T, typename Acc = T>
+    entry<T> make_entry(const std::string &name)
+    {
+        const std::string suffix = std::is_same_v<T, Acc> ? type_suffix<T>() : type_suffix<T>() + "_acc_" + type_suffix<Acc>();
+
+        return {name + "_" + suffix, [](std::size_t max_size)
+                { return std::unique_ptr<ar_engine<T>>(new ar_engine_impl<AR, T>(max_size)); }};
+    }
+
+    /**
+     * @brief All the estimators instantiated for the data type T, followed by the mixed precision
+     * ones accumulating in wider_t<T> if T has a wider type.
+     * The recursive denominator of the optimized_den estimators diverges in float on real audio (NaN/Inf
+     * errors, even with the compensated reductions), so for float they only run accumulating in double
+     * (burg_optimized_den_float_acc_double)
+     */
+    template <typename T>
+    const std::vector<entry<T>> &engines()
+    {
+        static const std::vector<entry<T>> list = []
+        {
+            using Acc = wider_t<T>;
+
+            constexpr bool stable_den = !std::is_same_v<T, float>;
+            std::vector<entry<T>> l;
+
+            l.push_back(make_entry<burg_basic<T>, T>("burg_basic"));
+            if constexpr (stable_den)
+                l.push_back(make_entry<burg_optimized_den<T>, T>("burg_optimized_den"));
+            l.push_back(make_entry<burg_optimized_den_sqrt<T>, T>("burg_optimized_den_sqrt"));
+            l.push_back(make_entry<compensated_burg_basic<T>, T>("compensated_burg_basic"));
+            if constexpr (stable_den)
+                l.push_back(make_entry<compensated_burg_optimized_den<T>, T>("compensated_burg_optimized_den"));
+            l.push_back(make_entry<compensated_burg_optimized_den_sqrt<T>, T>("compensated_burg_optimized_den_sqrt"));
+
+            if constexpr (!std::is_same_v<T, Acc>)
+            {
+                l.push_back(make_entry<burg_basic<T, Acc>, T, Acc>("burg_basic"));
+                l.push_back(make_entry<burg_optimized_den<T, Acc>, T, Acc>("burg_optimized_den"));
+                l.push_back(make_entry<burg_optimized_den_sqrt<T, Acc>, T, Acc>("burg_optimized_den_sqrt"));
+            }
+
+            return l;
+        }();
+
+        return list;
+    }
+
+    /**
+     * @brief Names of every registered engine, for every supported data type
+     */
+    inline std::vector<std::string> names()
+    {
+        std::vector<std::string> res;
+
+        for (const auto &e : engines<float>())
+            res.push_back(e.name);
+        for (const auto &e : engines<double>())
+            res.push_back(e.name);
+        for (const auto &e : engines<long double>())
+            res.push_back(e.name);
+
+        return res;
+    }
+
+    /**
+     * @brief Names of the engines run when none is explicitly requested
+     */
+    inline std::vector<std::string> default_names()
+    {
+        std::vector<std::string> res;
+
+        for (const auto &e : engines<double>())
+            res.push_back(e.name);
+
+        return res;
+    }
+
+    /**
+     * @brief Checks that every requested name is a registered engine
+     */
+    inline void validate(const std::vector<std::string> &selected)
+    {
+        const auto all = names();
+
+        for (const auto &name : selected)
+        {
+            if (std::find(all.begin(), all.end(), name) == all.end())
+            {
+                throw std::runtime_error("unknown engine " + name);
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the entries of type T among the selected names, in registry order
+     */
+    template <typename T>
+    std::vector<entry<T>> select(const std::vector<std::string> &selected)
+    {
+        std::vector<entry<T>> res;
+
+        for (const auto &e : engines<T>())
+        {
+            if (std::find(selected.begin(), selected.end(), e.name) != selected.end())
+            {
+                res.push_back(e);
+            }
+        }
+
+        return res;
+    }
+
+    struct options
+    {
+        std::string output{"."};          // Directory where the per-engine results are written
+        std::vector<std::string> engines; // Selected engines (default_names() if none)
+        bool list{false};                 // Only print the registered engines
+        std::string isa;                  // Instruction set of the kernels (best supported if empty)
+        std::size_t jobs{0};              // Worker threads (hardware threads if 0)
+        bool multichannel{false};         // Use every channel of the files, adding the multichannel engine
+        double reuse{0};                  // Residual growth tolerated before refitting a cached model (see model_cache.hpp), no cache if 0
+        std::string select;               // Order criterion of an additional model of selected order (see order_selection.hpp), none if empty
+        std::string profile;              // Profile of burg-autotune dispatching to the fastest engine (see autotune.hpp), none if empty. burg-plc only
+        double max_error{1e-4};           // Largest reflection coefficient error of an engine dispatched to by the profile. burg-plc only
+        bool counters{false};             // Record the hardware performance counters of fit and predict (see counters.hpp)
+        bool raw_times{false};            // Write the time of every fit and predict, not only the latency histograms (see histogram.hpp)
+        std::vector<std::string> given;   // Long names of the options on the command line, see reject_unsupported()
+    };
+
+    /**
+     * @brief Parses the command line shared by the drivers:
+     * [-o <output dir>] [-l] [--isa <scalar|sse2|avx2|avx512>] [-j <threads>] [-m] [--reuse <threshold>] [--select <aic|fpe|mdl|cat|stall>]
+     * [--profile <profile.json>] [--max-error <bound>] [--counters] [--raw-times] [engine ...]
+     */
+    inline options parse_args(int argc, char *argv[])
+    {
+        options opts{};
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg{argv[i]};
+
+            if (arg == "-o" || arg == "--output")
+            {
+                opts.given.push_back("--output");
+                if (i + 1 >= argc)
+                {
+                    throw std::runtime_error(arg + " requires a directory");
+                }
+                opts.output = argv[++i];
+            }
+            else if (arg == "--isa")
+            {
+                opts.given.push_back("--isa");
+                if (i + 1 >= argc)
+                {
+                    throw std::runtime_error(arg + " requires an instruction set");
+                }
+                opts.isa = argv[++i];
+            }
+            else if (arg == "-j" || arg == "--jobs")
+            {
+                opts.given.push_back("--jobs");
+                if (i + 1 >= argc)
+                {
+                    throw std::runtime_error(arg + " requires a number of threads");
+                }
+
+                const std::string jobs{argv[++i]};
+                std::size_t parsed = 0;
+
+                // std::stoul accepts a sign and wraps a negative number around, so only digits are read
+                if (!jobs.empty() && std::isdigit(static_cast<unsigned char>(jobs[0])))
+                {
+                    try
+                    {
+                        opts.jobs = std::stoul(jobs, &parsed);
+                    }
+                    catch (std::exception &)
+                    {
+                        parsed = 0;
+                    }
+                }
+
+                if (parsed == 0 || parsed != jobs.size())
+                {
+                    throw std::runtime_error(jobs + " is not a valid number of threads");
+                }
+            }
+            else if (arg == "--reuse")
+            {
+                opts.given.push_back("--reuse");
+                if (i + 1 >= argc)
+                {
+                    throw std::runtime_error(arg + " requires a threshold");
+                }
+
+                try
+                {
+                    opts.reuse = std::stod(argv[++i]);
+                }
+                catch (std::exception &)
+                {
+                    throw std::runtime_error(std::string(argv[i]) + " is not a valid threshold");
+                }
+
+                if (opts.reuse < 0)
+                {
+                    throw std::runtime_error("the reuse threshold can not be negative");
+                }
+            }
+            else if (arg == "--select")
+            {
+                opts.given.push_back("--select");
+                if (i + 1 >= argc)
+                {
+                    throw std::runtime_error(arg + " requires a criterion");
+                }
+                opts.select = argv[++i];
+                criterion_from_name(opts.select);
+            }
+            else if (arg == "--profile")
+            {
+                opts.given.push_back("--profile");
+                if (i + 1 >= argc)
+                {
+                    throw std::runtime_error(arg + " requires a file");
+                }
+                opts.profile = argv[++i];
+            }
+            else if (arg == "--max-error")
+            {
+                opts.given.push_back("--max-error");
+                if (i + 1 >= argc)
+                {
+                    throw std::runtime_error(arg + " requires a bound");
+                }
+
+                try
+                {
+                    opts.max_error = std::stod(argv[++i]);
+                }
+                catch (std::exception &)
+                {
+                    throw std::runtime_error(std::string(argv[i]) + " is not a valid bound");
+                }
+            }
+            else if (arg == "--counters")
+            {
+                opts.given.push_back("--counters");
+                opts.counters = true;
+            }
+            else if (arg == "--raw-times")
+            {
+                opts.given.push_back("--raw-times");
+                opts.raw_times = true;
+            }
+            else if (arg == "-m" || arg == "--multichannel")
+            {
+                opts.given.push_back("--multichannel");
+                opts.multichannel = true;
+            }
+            else if (arg == "-l" || arg == "--list")
+            {
+                opts.given.push_back("--list");
+                opts.list = true;
+            }
+            else
+            {
+                opts.engines.push_back(arg);
+            }
+        }
+
+        if (opts.engines.empty())
+        {
+            opts.engines = default_names();
+        }
+
+        validate(opts.engines);
+
+        return opts;
+    }
+
+    /**
+     * @brief Throws if an option the driver does not read, given by its long name in supported, was on
+     * the command line: it would otherwise be silently ignored
+     */
+    inline void reject_unsupported(const options &opts, const std::string &driver, const std::vector<std::string> &supported)
+    {
+        for (const auto &name : opts.given)
+        {
+            if (std::find(supported.begin(), supported.end(), name) == supported.end())
+            {
+                throw std::runtime_error(driver + " does not support " + name);
+            }
+        }
+    }
+}
+
+#endif
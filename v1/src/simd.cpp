@@ -0,0 +1,269 @@
+#include "simd.hpp"
+#include "la.hpp"
+#include "precise_la.hpp"
+#include <stdexcept>
+
+namespace la
+{
+    namespace simd
+    {
+#if defined(LA_SIMD_X86)
+        // Defined in simd_<isa>.cpp, each compiled for its own instruction set
+        extern const kernel_table sse2_kernels;
+        extern const kernel_table avx2_kernels;
+        extern const kernel_table avx512_kernels;
+        extern const basic_kernel_table<float> sse2_kernels_float;
+        extern const basic_kernel_table<float> avx2_kernels_float;
+        extern const basic_kernel_table<float> avx512_kernels_float;
+        extern const widening_table sse2_kernels_widening;
+        extern const widening_table avx2_kernels_widening;
+        extern const widening_table avx512_kernels_widening;
+        extern const compensated_widening_table sse2_kernels_compensated;
+        extern const compensated_widening_table avx2_kernels_compensated;
+        extern const compensated_widening_table avx512_kernels_compensated;
+#endif
+
+        // Reference implementation
+        template <typename T>
+        static const basic_kernel_table<T> scalar_kernels{
+            isa::SCALAR,
+            "scalar",
+            [](const T *x, const T *y, std::size_t N)
+            { return la::prod::dot_basic(x, y, N); },
+            [](const T *b, const T *f, std::size_t N)
+            {
+                auto [bf, ff, bb] = la::lattice::dot_3_basic(b, f, N);
+                return basic_reductions<T>{bf, ff, bb};
+            },
+            [](T *b, T *f, T k, std::size_t N)
+            { la::lattice::reflect_basic(b, f, k, N); },
+            [](T *b, T *f, T k, std::size_t N)
+            { return la::lattice::reflect_dot_basic(b, f, k, N); },
+            [](T *b, T *f, T k, std::size_t N)
+            {
+                auto [bf, ff, bb] = la::lattice::reflect_dot_3_basic(b, f, k, N);
+                return basic_reductions<T>{bf, ff, bb};
+            },
+            [](const T *x, const T *y, std::size_t N)
+            {
+                auto [r, e] = precise_la::prod::dot_2(x, y, N);
+                return basic_compensated<T>{r, e};
+            },
+            [](T *b, T *f, T k, std::size_t N)
+            { precise_la::lattice::reflect_basic(b, f, k, N); },
+            &la::batch::dot_3_basic<T>,
+            &la::batch::reflect_dot_3_basic<T>,
+            &la::metrics::error_sums_basic<T>,
+        };
+
+        static const widening_table scalar_kernels_widening{
+            isa::SCALAR,
+            "scalar",
+            [](const float *x, const float *y, std::size_t N)
+            { return la::prod::dot_basic<float, double>(x, y, N); },
+            [](const float *b, const float *f, std::size_t N)
+            {
+                auto [bf, ff, bb] = la::lattice::dot_3_basic<float, double>(b, f, N);
+                return reductions{bf, ff, bb};
+            },
+            [](float *b, float *f, double k, std::size_t N)
+            { la::lattice::reflect_basic(b, f, k, N); },
+            [](float *b, float *f, double k, std::size_t N)
+            { return la::lattice::reflect_dot_basic(b, f, k, N); },
+            [](float *b, float *f, double k, std::size_t N)
+            {
+                auto [bf, ff, bb] = la::lattice::reflect_dot_3_basic(b, f, k, N);
+                return reductions{bf, ff, bb};
+            },
+        };
+
+        static const compensated_widening_table scalar_kernels_compensated{
+            isa::SCALAR,
+            "scalar",
+            [](const double *x, const double *y, std::size_t N)
+            { return la::simd::to_kernel(la::prod::dot_basic<double, precise_la::double_double>(x, y, N)); },
+            [](const double *b, const double *f, std::size_t N)
+            {
+                auto [bf, ff, bb] = la::lattice::dot_3_basic<double, precise_la::double_double>(b, f, N);
+                return basic_reductions<compensated>{la::simd::to_kernel(bf), la::simd::to_kernel(ff), la::simd::to_kernel(bb)};
+            },
+            [](double *b, double *f, compensated k, std::size_t N)
+            { la::lattice::reflect_basic(b, f, la::simd::from_kernel<precise_la::double_double>(k), N); },
+            [](double *b, double *f, compensated k, std::size_t N)
+            { return la::simd::to_kernel(la::lattice::reflect_dot_basic(b, f, la::simd::from_kernel<precise_la::double_double>(k), N)); },
+            [](double *b, double *f, compensated k, std::size_t N)
+            {
+                auto [bf, ff, bb] = la::lattice::reflect_dot_3_basic(b, f, la::simd::from_kernel<precise_la::double_double>(k), N);
+                return basic_reductions<compensated>{la::simd::to_kernel(bf), la::simd::to_kernel(ff), la::simd::to_kernel(bb)};
+            },
+        };
+
+        template <typename T>
+        static const basic_kernel_table<T> &table(isa id)
+        {
+            switch (id)
+            {
+#if defined(LA_SIMD_X86)
+            case isa::SSE2:
+                if constexpr (std::is_same_v<T, float>)
+                    return sse2_kernels_float;
+                else
+                    return sse2_kernels;
+            case isa::AVX2:
+                if constexpr (std::is_same_v<T, float>)
+                    return avx2_kernels_float;
+                else
+                    return avx2_kernels;
+            case isa::AVX512:
+                if constexpr (std::is_same_v<T, float>)
+                    return avx512_kernels_float;
+                else
+                    return avx512_kernels;
+#endif
+            default:
+                return scalar_kernels<T>;
+            }
+        }
+
+        template <typename S, typename A>
+        static const basic_widening_table<S, A> &widening(isa id)
+        {
+            switch (id)
+            {
+#if defined(LA_SIMD_X86)
+            case isa::SSE2:
+                if constexpr (std::is_same_v<S, float>)
+                    return sse2_kernels_widening;
+                else
+                    return sse2_kernels_compensated;
+            case isa::AVX2:
+                if constexpr (std::is_same_v<S, float>)
+                    return avx2_kernels_widening;
+                else
+                    return avx2_kernels_compensated;
+            case isa::AVX512:
+                if constexpr (std::is_same_v<S, float>)
+                    return avx512_kernels_widening;
+                else
+                    return avx512_kernels_compensated;
+#endif
+            default:
+                if constexpr (std::is_same_v<S, float>)
+                    return scalar_kernels_widening;
+                else
+                    return scalar_kernels_compensated;
+            }
+        }
+
+        template <typename T>
+        static const basic_kernel_table<T> *&current()
+        {
+            static const basic_kernel_table<T> *kernels = &table<T>(best());
+            return kernels;
+        }
+
+        template <typename S, typename A>
+        static const basic_widening_table<S, A> *&current_widening()
+        {
+            static const basic_widening_table<S, A> *kernels = &widening<S, A>(best());
+            return kernels;
+        }
+
+        template <>
+        const basic_kernel_table<double> &active<double>()
+        {
+            return *current<double>();
+        }
+
+        template <>
+        const basic_kernel_table<float> &active<float>()
+        {
+            return *current<float>();
+        }
+
+        template <>
+        const widening_table &active_widening<float, double>()
+        {
+            return *current_widening<float, double>();
+        }
+
+        template <>
+        const compensated_widening_table &active_widening<double, compensated>()
+        {
+            return *current_widening<double, compensated>();
+        }
+
+        bool supported(isa id)
+        {
+            switch (id)
+            {
+            case isa::SCALAR:
+                return true;
+#if defined(LA_SIMD_X86)
+            case isa::SSE2:
+                return __builtin_cpu_supports("sse2");
+            case isa::AVX2:
+                return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+            case isa::AVX512:
+                return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("fma");
+#endif
+            default:
+                return false;
+            }
+        }
+
+        isa best()
+        {
+            for (isa id : {isa::AVX512, isa::AVX2, isa::SSE2})
+            {
+                if (supported(id))
+                {
+                    return id;
+                }
+            }
+
+            return isa::SCALAR;
+        }
+
+        void select(isa id)
+        {
+            if (!supported(id))
+            {
+                throw std::runtime_error(std::string(name(id)) + " kernels are not supported");
+            }
+
+            current<double>() = &table<double>(id);
+            current<float>() = &table<float>(id);
+            current_widening<float, double>() = &widening<float, double>(id);
+            current_widening<double, compensated>() = &widening<double, compensated>(id);
+        }
+
+        const char *name(isa id)
+        {
+            switch (id)
+            {
+            case isa::SSE2:
+                return "sse2";
+            case isa::AVX2:
+                return "avx2";
+            case isa::AVX512:
+                return "avx512";
+            default:
+                return "scalar";
+            }
+        }
+
+        isa from_name(const std::string &s)
+        {
+            for (isa id : {isa::SCALAR, isa::SSE2, isa::AVX2, isa::AVX512})
+            {
+                if (s == name(id))
+                {
+                    return id;
+                }
+            }
+
+            throw std::runtime_error("unknown instruction set " + s);
+        }
+    }
+}
@@ -0,0 +1,170 @@
+#ifndef __SIMD_HPP__
+#define __SIMD_HPP__
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+namespace la
+{
+    namespace simd
+    {
+        enum class isa
+        {
+            SCALAR,
+            SSE2,
+            AVX2,
+            AVX512
+        };
+
+        /**
+         * @brief The reductions of a BURG's iteration: [b·f, f·f, b·b]
+         */
+        template <typename T>
+        struct basic_reductions
+        {
+            T bf;
+            T ff;
+            T bb;
+        };
+
+        using reductions = basic_reductions<double>;
+
+        /**
+         * @brief A compensated result: [result, error]
+         */
+        template <typename T>
+        struct basic_compensated
+        {
+            T result;
+            T error;
+        };
+
+        using compensated = basic_compensated<double>;
+
+        /**
+         * @brief The sums of an error metrics pass of the estimates y of x: [Σ|y - x|, Σ(y - x)², max|y - x|, Σx²]
+         */
+        template <typename T>
+        struct basic_error_sums
+        {
+            T abs;
+            T sq;
+            T max_abs;
+            T signal;
+        };
+
+        /**
+         * @brief The kernels of one instruction set for the data type T.
+         * Every implementation uses a fixed number of accumulators and a fixed reduction
+         * order, so the results are deterministic for a given instruction set
+         */
+        template <typename T>
+        struct basic_kernel_table
+        {
+            isa id;
+            const char *name;
+
+            T (*dot)(const T *x, const T *y, std::size_t N);
+            basic_reductions<T> (*dot_3)(const T *b, const T *f, std::size_t N);
+            void (*reflect)(T *b, T *f, T k, std::size_t N);
+            T (*reflect_dot)(T *b, T *f, T k, std::size_t N);
+            basic_reductions<T> (*reflect_dot_3)(T *b, T *f, T k, std::size_t N);
+
+            // Compensated kernels (see precise_la)
+            basic_compensated<T> (*dot_2)(const T *x, const T *y, std::size_t N);
+            void (*reflect_2)(T *b, T *f, T k, std::size_t N);
+
+            // Vertical kernels on interleaved windows (see la::batch)
+            void (*batch_dot_3)(const T *b, const T *f, std::size_t N, std::size_t lanes, T *bf, T *ff, T *bb);
+            void (*batch_reflect_dot_3)(T *b, T *f, const T *k, std::size_t N, std::size_t lanes, T *bf, T *ff, T *bb);
+
+            // Error metrics (see stats::metrics)
+            basic_error_sums<T> (*error_sums)(const T *x, const T *y, std::size_t N);
+        };
+
+        using kernel_table = basic_kernel_table<double>;
+
+        /**
+         * @brief The kernels of one instruction set for mixed precision: the arrays are stored as S and
+         * every operation is computed in A. The updated errors are rounded to S when stored and the
+         * reductions use the rounded values, so they are consistent with the arrays of the next order
+         */
+        template <typename S, typename A>
+        struct basic_widening_table
+        {
+            isa id;
+            const char *name;
+
+            A (*dot)(const S *x, const S *y, std::size_t N);
+            basic_reductions<A> (*dot_3)(const S *b, const S *f, std::size_t N);
+            void (*reflect)(S *b, S *f, A k, std::size_t N);
+            A (*reflect_dot)(S *b, S *f, A k, std::size_t N);
+            basic_reductions<A> (*reflect_dot_3)(S *b, S *f, A k, std::size_t N);
+        };
+
+        using widening_table = basic_widening_table<float, double>;
+
+        // Double storage with compensated accumulators (see precise_la::double_double): every lane accumulates
+        // the reductions with Dot2 and the updates use the compensated reflection coefficient
+        using compensated_widening_table = basic_widening_table<double, compensated>;
+
+        /**
+         * @brief Whether there are kernels for the data type T: double and float.
+         * The other types use the basic versions of la and precise_la
+         */
+        template <typename T>
+        inline constexpr bool vectorized = std::is_same_v<T, double> || std::is_same_v<T, float>;
+
+        /**
+         * @brief The kernels in use for the data type T (double or float).
+         * Defaults to the best instruction set supported by the CPU
+         */
+        template <typename T = double>
+        const basic_kernel_table<T> &active();
+
+        template <>
+        const basic_kernel_table<double> &active<double>();
+
+        template <>
+        const basic_kernel_table<float> &active<float>();
+
+        /**
+         * @brief Whether there are mixed precision kernels for storage S and accumulator A: float and double,
+         * double and compensated. The other pairs use the basic versions of la
+         */
+        template <typename S, typename A>
+        inline constexpr bool widening_vectorized = (std::is_same_v<S, float> && std::is_same_v<A, double>) ||
+                                                    (std::is_same_v<S, double> && std::is_same_v<A, compensated>);
+
+        /**
+         * @brief The mixed precision kernels in use for storage S and accumulator A
+         */
+        template <typename S, typename A>
+        const basic_widening_table<S, A> &active_widening();
+
+        template <>
+        const widening_table &active_widening<float, double>();
+
+        template <>
+        const compensated_widening_table &active_widening<double, compensated>();
+
+        /**
+         * @brief The best instruction set supported by the CPU (from CPUID)
+         */
+        isa best();
+
+        bool supported(isa id);
+
+        /**
+         * @brief Switches the kernels in use for every data type, e.g. to isa::SCALAR to get the reference results.
+         * Throws if the CPU or the build does not support the instruction set
+         */
+        void select(isa id);
+
+        const char *name(isa id);
+        isa from_name(const std::string &name);
+    }
+}
+
+#endif
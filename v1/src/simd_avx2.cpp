@@ -0,0 +1,159 @@
+#include <immintrin.h>
+#include "simd_kernels.hpp"
+
+namespace
+{
+    struct avx2_ops
+    {
+        using value = double;
+        using narrow = float;
+        using narrow_reg = __m128;
+        using reg = __m256d;
+        static constexpr std::size_t width = 4;
+
+        static inline reg zero() { return _mm256_setzero_pd(); }
+        static inline reg set1(double x) { return _mm256_set1_pd(x); }
+        static inline reg load(const double *p) { return _mm256_loadu_pd(p); }
+        static inline void store(double *p, reg v) { _mm256_storeu_pd(p, v); }
+        static inline reg load_narrow(const float *p) { return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+        static inline void store_narrow(float *p, narrow_reg v) { _mm_storeu_ps(p, v); }
+        static inline narrow_reg to_narrow(reg v) { return _mm256_cvtpd_ps(v); }
+        static inline reg widen(narrow_reg v) { return _mm256_cvtps_pd(v); }
+        static inline reg shift_in(reg a, reg b) { return _mm256_shuffle_pd(a, _mm256_permute2f128_pd(a, b, 0x21), 0b0101); }
+        static inline reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+        static inline reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+        static inline reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+        static inline double fmadd1(double a, double b, double c) { return _mm_cvtsd_f64(_mm_fmadd_sd(_mm_set_sd(a), _mm_set_sd(b), _mm_set_sd(c))); }
+        static inline reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+        static inline reg abs(reg v) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), v); }
+        static inline reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+        static inline reg prod_err(reg a, reg b, reg p) { return _mm256_fmsub_pd(a, b, p); }
+        static inline double prod_err1(double a, double b, double p) { return _mm_cvtsd_f64(_mm_fmsub_sd(_mm_set_sd(a), _mm_set_sd(b), _mm_set_sd(p))); }
+
+        static inline double hsum(reg v)
+        {
+            double lanes[width];
+            _mm256_storeu_pd(lanes, v);
+
+            return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        }
+
+        static inline double hmax(reg v)
+        {
+            double lanes[width];
+            _mm256_storeu_pd(lanes, v);
+
+            double r = lanes[0];
+            for (std::size_t i = 1; i < width; i++)
+            {
+                r = lanes[i] > r ? lanes[i] : r;
+            }
+
+            return r;
+        }
+    };
+
+    struct avx2_ops_float
+    {
+        using value = float;
+        using reg = __m256;
+        static constexpr std::size_t width = 8;
+
+        static inline reg zero() { return _mm256_setzero_ps(); }
+        static inline reg set1(float x) { return _mm256_set1_ps(x); }
+        static inline reg load(const float *p) { return _mm256_loadu_ps(p); }
+        static inline void store(float *p, reg v) { _mm256_storeu_ps(p, v); }
+        static inline reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+        static inline reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+        static inline reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+        static inline float fmadd1(float a, float b, float c) { return _mm_cvtss_f32(_mm_fmadd_ss(_mm_set_ss(a), _mm_set_ss(b), _mm_set_ss(c))); }
+        static inline reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+        static inline reg abs(reg v) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v); }
+        static inline reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+        static inline reg prod_err(reg a, reg b, reg p) { return _mm256_fmsub_ps(a, b, p); }
+        static inline float prod_err1(float a, float b, float p) { return _mm_cvtss_f32(_mm_fmsub_ss(_mm_set_ss(a), _mm_set_ss(b), _mm_set_ss(p))); }
+
+        static inline float hsum(reg v)
+        {
+            float lanes[width];
+            _mm256_storeu_ps(lanes, v);
+
+            return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+        }
+
+        static inline float hmax(reg v)
+        {
+            float lanes[width];
+            _mm256_storeu_ps(lanes, v);
+
+            float r = lanes[0];
+            for (std::size_t i = 1; i < width; i++)
+            {
+                r = lanes[i] > r ? lanes[i] : r;
+            }
+
+            return r;
+        }
+    };
+}
+
+namespace la
+{
+    namespace simd
+    {
+        extern const kernel_table avx2_kernels;
+        extern const basic_kernel_table<float> avx2_kernels_float;
+        extern const widening_table avx2_kernels_widening;
+        extern const compensated_widening_table avx2_kernels_compensated;
+
+        const kernel_table avx2_kernels{
+            isa::AVX2,
+            "avx2",
+            &kernels::dot<avx2_ops>,
+            &kernels::dot_3<avx2_ops>,
+            &kernels::reflect<avx2_ops>,
+            &kernels::reflect_dot<avx2_ops>,
+            &kernels::reflect_dot_3<avx2_ops>,
+            &kernels::dot_2<avx2_ops>,
+            &kernels::reflect_2<avx2_ops>,
+            &kernels::batch_dot_3<avx2_ops>,
+            &kernels::batch_reflect_dot_3<avx2_ops>,
+            &kernels::error_sums<avx2_ops>,
+        };
+
+        const basic_kernel_table<float> avx2_kernels_float{
+            isa::AVX2,
+            "avx2",
+            &kernels::dot<avx2_ops_float>,
+            &kernels::dot_3<avx2_ops_float>,
+            &kernels::reflect<avx2_ops_float>,
+            &kernels::reflect_dot<avx2_ops_float>,
+            &kernels::reflect_dot_3<avx2_ops_float>,
+            &kernels::dot_2<avx2_ops_float>,
+            &kernels::reflect_2<avx2_ops_float>,
+            &kernels::batch_dot_3<avx2_ops_float>,
+            &kernels::batch_reflect_dot_3<avx2_ops_float>,
+            &kernels::error_sums<avx2_ops_float>,
+        };
+
+        const widening_table avx2_kernels_widening{
+            isa::AVX2,
+            "avx2",
+            &kernels::widening_dot<avx2_ops>,
+            &kernels::widening_dot_3<avx2_ops>,
+            &kernels::widening_reflect<avx2_ops>,
+            &kernels::widening_reflect_dot<avx2_ops>,
+            &kernels::widening_reflect_dot_3<avx2_ops>,
+        };
+
+        const compensated_widening_table avx2_kernels_compensated{
+            isa::AVX2,
+            "avx2",
+            &kernels::dot_2<avx2_ops>,
+            &kernels::compensated_dot_3<avx2_ops>,
+            &kernels::compensated_reflect<avx2_ops>,
+            &kernels::compensated_reflect_dot<avx2_ops>,
+            &kernels::compensated_reflect_dot_3<avx2_ops>,
+        };
+    }
+}
@@ -0,0 +1,166 @@
+#include <immintrin.h>
+#include "simd_kernels.hpp"
+
+namespace
+{
+    struct avx512_ops
+    {
+        using value = double;
+        using narrow = float;
+        using narrow_reg = __m256;
+        using reg = __m512d;
+        static constexpr std::size_t width = 8;
+
+        static inline reg zero() { return _mm512_setzero_pd(); }
+        static inline reg set1(double x) { return _mm512_set1_pd(x); }
+        static inline reg load(const double *p) { return _mm512_loadu_pd(p); }
+        static inline void store(double *p, reg v) { _mm512_storeu_pd(p, v); }
+        // The zero masked forms, the unmasked ones trip -Wmaybe-uninitialized on their undefined source
+        static inline reg load_narrow(const float *p) { return _mm512_maskz_cvtps_pd(0xFF, _mm256_loadu_ps(p)); }
+        static inline void store_narrow(float *p, narrow_reg v) { _mm256_storeu_ps(p, v); }
+        static inline narrow_reg to_narrow(reg v) { return _mm512_maskz_cvtpd_ps(0xFF, v); }
+        static inline reg widen(narrow_reg v) { return _mm512_maskz_cvtps_pd(0xFF, v); }
+        static inline reg shift_in(reg a, reg b) { return _mm512_castsi512_pd(_mm512_maskz_alignr_epi64(0xFF, _mm512_castpd_si512(b), _mm512_castpd_si512(a), 1)); }
+        static inline reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+        static inline reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+        static inline reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+        static inline double fmadd1(double a, double b, double c) { return _mm_cvtsd_f64(_mm_fmadd_sd(_mm_set_sd(a), _mm_set_sd(b), _mm_set_sd(c))); }
+        static inline reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+        static inline reg abs(reg v) { return _mm512_abs_pd(v); }
+        static inline reg max(reg a, reg b) { return _mm512_maskz_max_pd(0xFF, a, b); }
+        static inline reg prod_err(reg a, reg b, reg p) { return _mm512_fmsub_pd(a, b, p); }
+        static inline double prod_err1(double a, double b, double p) { return _mm_cvtsd_f64(_mm_fmsub_sd(_mm_set_sd(a), _mm_set_sd(b), _mm_set_sd(p))); }
+
+        static inline double hsum(reg v)
+        {
+            double lanes[width];
+            _mm512_storeu_pd(lanes, v);
+
+            return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+        }
+
+        static inline double hmax(reg v)
+        {
+            double lanes[width];
+            _mm512_storeu_pd(lanes, v);
+
+            double r = lanes[0];
+            for (std::size_t i = 1; i < width; i++)
+            {
+                r = lanes[i] > r ? lanes[i] : r;
+            }
+
+            return r;
+        }
+    };
+
+    struct avx512_ops_float
+    {
+        using value = float;
+        using reg = __m512;
+        static constexpr std::size_t width = 16;
+
+        static inline reg zero() { return _mm512_setzero_ps(); }
+        static inline reg set1(float x) { return _mm512_set1_ps(x); }
+        static inline reg load(const float *p) { return _mm512_loadu_ps(p); }
+        static inline void store(float *p, reg v) { _mm512_storeu_ps(p, v); }
+        static inline reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+        static inline reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+        static inline reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+        static inline float fmadd1(float a, float b, float c) { return _mm_cvtss_f32(_mm_fmadd_ss(_mm_set_ss(a), _mm_set_ss(b), _mm_set_ss(c))); }
+        static inline reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+        static inline reg abs(reg v) { return _mm512_abs_ps(v); }
+        static inline reg max(reg a, reg b) { return _mm512_maskz_max_ps(0xFFFF, a, b); }
+        static inline reg prod_err(reg a, reg b, reg p) { return _mm512_fmsub_ps(a, b, p); }
+        static inline float prod_err1(float a, float b, float p) { return _mm_cvtss_f32(_mm_fmsub_ss(_mm_set_ss(a), _mm_set_ss(b), _mm_set_ss(p))); }
+
+        static inline float hsum(reg v)
+        {
+            float lanes[width];
+            _mm512_storeu_ps(lanes, v);
+
+            float r[4];
+            for (std::size_t i = 0; i < 4; i++)
+            {
+                r[i] = (lanes[4 * i] + lanes[4 * i + 1]) + (lanes[4 * i + 2] + lanes[4 * i + 3]);
+            }
+
+            return (r[0] + r[1]) + (r[2] + r[3]);
+        }
+
+        static inline float hmax(reg v)
+        {
+            float lanes[width];
+            _mm512_storeu_ps(lanes, v);
+
+            float r = lanes[0];
+            for (std::size_t i = 1; i < width; i++)
+            {
+                r = lanes[i] > r ? lanes[i] : r;
+            }
+
+            return r;
+        }
+    };
+}
+
+namespace la
+{
+    namespace simd
+    {
+        extern const kernel_table avx512_kernels;
+        extern const basic_kernel_table<float> avx512_kernels_float;
+        extern const widening_table avx512_kernels_widening;
+        extern const compensated_widening_table avx512_kernels_compensated;
+
+        const kernel_table avx512_kernels{
+            isa::AVX512,
+            "avx512",
+            &kernels::dot<avx512_ops>,
+            &kernels::dot_3<avx512_ops>,
+            &kernels::reflect<avx512_ops>,
+            &kernels::reflect_dot<avx512_ops>,
+            &kernels::reflect_dot_3<avx512_ops>,
+            &kernels::dot_2<avx512_ops>,
+            &kernels::reflect_2<avx512_ops>,
+            &kernels::batch_dot_3<avx512_ops>,
+            &kernels::batch_reflect_dot_3<avx512_ops>,
+            &kernels::error_sums<avx512_ops>,
+        };
+
+        const basic_kernel_table<float> avx512_kernels_float{
+            isa::AVX512,
+            "avx512",
+            &kernels::dot<avx512_ops_float>,
+            &kernels::dot_3<avx512_ops_float>,
+            &kernels::reflect<avx512_ops_float>,
+            &kernels::reflect_dot<avx512_ops_float>,
+            &kernels::reflect_dot_3<avx512_ops_float>,
+            &kernels::dot_2<avx512_ops_float>,
+            &kernels::reflect_2<avx512_ops_float>,
+            &kernels::batch_dot_3<avx512_ops_float>,
+            &kernels::batch_reflect_dot_3<avx512_ops_float>,
+            &kernels::error_sums<avx512_ops_float>,
+        };
+
+        const widening_table avx512_kernels_widening{
+            isa::AVX512,
+            "avx512",
+            &kernels::widening_dot<avx512_ops>,
+            &kernels::widening_dot_3<avx512_ops>,
+            &kernels::widening_reflect<avx512_ops>,
+            &kernels::widening_reflect_dot<avx512_ops>,
+            &kernels::widening_reflect_dot_3<avx512_ops>,
+        };
+
+        const compensated_widening_table avx512_kernels_compensated{
+            isa::AVX512,
+            "avx512",
+            &kernels::dot_2<avx512_ops>,
+            &kernels::compensated_dot_3<avx512_ops>,
+            &kernels::compensated_reflect<avx512_ops>,
+            &kernels::compensated_reflect_dot<avx512_ops>,
+            &kernels::compensated_reflect_dot_3<avx512_ops>,
+        };
+    }
+}
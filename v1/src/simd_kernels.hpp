@@ -0,0 +1,944 @@
+#ifndef __SIMD_KERNELS_HPP__
+#define __SIMD_KERNELS_HPP__
+
+// Generic SIMD implementations of the la::simd kernels.
+// Included only by the simd_<isa>.cpp translation units, each compiled with the flags of its
+// instruction set: the kernels have internal linkage so that the linker never mixes them up.
+// Avoid calling into the standard library here, its inline functions would be emitted with the
+// instruction set of this translation unit and could be picked for the rest of the program.
+//
+// V must provide:
+//   - value:                 the data type, double or float
+//   - reg:                   the vector register type
+//   - width:                 the number of values in reg
+//   - zero(), set1(x):       register initialization
+//   - load(p), store(p, v):  unaligned memory access
+//   - add(a, b), mul(a, b):  lane-wise operations
+//   - fmadd(a, b, c):        a * b + c lane-wise
+//   - fmadd1(a, b, c):       a * b + c on scalars, rounded exactly as fmadd
+//   - sub(a, b):             lane-wise subtraction
+//   - prod_err(a, b, p):     the exact error a * b - p of the product p = fl(a * b), lane-wise
+//   - prod_err1(a, b, p):    the same on scalars
+//   - hsum(v):               sum of the lanes, in a fixed order
+//   - abs(v), max(a, b):     lane-wise absolute value and maximum
+//   - hmax(v):               maximum of the lanes
+//
+// and, for the widening kernels only:
+//   - narrow:                the storage data type, float
+//   - narrow_reg:            a register holding width narrow values
+//   - load_narrow(p):        width narrow values, widened
+//   - store_narrow(p, v):    stores the width narrow values of v
+//   - to_narrow(v):          the lanes rounded to narrow
+//   - widen(v):              the narrow lanes widened, exactly
+//
+// and, for the widening and the compensated kernels:
+//   - shift_in(a, b):        [a[1], ..., a[width - 1], b[0]]
+
+#include <cstddef>
+#include "simd.hpp"
+
+namespace
+{
+    namespace kernels
+    {
+        template <typename V, typename T = typename V::value>
+        T dot(const T *x, const T *y, std::size_t N)
+        {
+            constexpr std::size_t W = V::width;
+
+            // Four independent accumulators to hide the latency of the additions
+            typename V::reg acc0 = V::zero(), acc1 = V::zero(), acc2 = V::zero(), acc3 = V::zero();
+
+            std::size_t j = 0;
+            for (; j + 4 * W <= N; j += 4 * W)
+            {
+                acc0 = V::fmadd(V::load(&x[j]), V::load(&y[j]), acc0);
+                acc1 = V::fmadd(V::load(&x[j + W]), V::load(&y[j + W]), acc1);
+                acc2 = V::fmadd(V::load(&x[j + 2 * W]), V::load(&y[j + 2 * W]), acc2);
+                acc3 = V::fmadd(V::load(&x[j + 3 * W]), V::load(&y[j + 3 * W]), acc3);
+            }
+            for (; j + W <= N; j += W)
+            {
+                acc0 = V::fmadd(V::load(&x[j]), V::load(&y[j]), acc0);
+            }
+
+            T r = V::hsum(V::add(V::add(acc0, acc1), V::add(acc2, acc3)));
+
+            for (; j < N; j++)
+            {
+                r = V::fmadd1(x[j], y[j], r);
+            }
+
+            return r;
+        }
+
+        template <typename V, typename T = typename V::value>
+        la::simd::basic_reductions<T> dot_3(const T *b, const T *f, std::size_t N)
+        {
+            constexpr std::size_t W = V::width;
+
+            // Two accumulators per reduction
+            typename V::reg bf0 = V::zero(), ff0 = V::zero(), bb0 = V::zero();
+            typename V::reg bf1 = V::zero(), ff1 = V::zero(), bb1 = V::zero();
+
+            std::size_t j = 0;
+            for (; j + 2 * W <= N; j += 2 * W)
+            {
+                typename V::reg b0 = V::load(&b[j]), f0 = V::load(&f[j]);
+                typename V::reg b1 = V::load(&b[j + W]), f1 = V::load(&f[j + W]);
+
+                bf0 = V::fmadd(b0, f0, bf0);
+                ff0 = V::fmadd(f0, f0, ff0);
+                bb0 = V::fmadd(b0, b0, bb0);
+                bf1 = V::fmadd(b1, f1, bf1);
+                ff1 = V::fmadd(f1, f1, ff1);
+                bb1 = V::fmadd(b1, b1, bb1);
+            }
+
+            T bf = V::hsum(V::add(bf0, bf1));
+            T ff = V::hsum(V::add(ff0, ff1));
+            T bb = V::hsum(V::add(bb0, bb1));
+
+            for (; j < N; j++)
+            {
+                bf = V::fmadd1(b[j], f[j], bf);
+                ff = V::fmadd1(f[j], f[j], ff);
+                bb = V::fmadd1(b[j], b[j], bb);
+            }
+
+            return {bf, ff, bb};
+        }
+
+        template <typename V, typename T = typename V::value>
+        void reflect(T *b, T *f, T k, std::size_t N)
+        {
+            constexpr std::size_t W = V::width;
+
+            typename V::reg kv = V::set1(k);
+
+            std::size_t j = 0;
+            for (; j + W <= N; j += W)
+            {
+                typename V::reg bj = V::load(&b[j]), fj = V::load(&f[j]);
+
+                V::store(&b[j], V::fmadd(kv, fj, bj));
+                V::store(&f[j], V::fmadd(kv, bj, fj));
+            }
+
+            for (; j < N; j++)
+            {
+                T bj = b[j], fj = f[j];
+
+                b[j] = V::fmadd1(k, fj, bj);
+                f[j] = V::fmadd1(k, bj, fj);
+            }
+        }
+
+        // The next order pairs b[m] with f[m + 1]. Instead of shuffling lanes across blocks, each block
+        // recomputes the updated f[m + 1 .. m + W] from the values that have not been stored yet.
+        // The recomputation is rounded exactly as the update, so it matches the values later stored.
+        template <typename V, bool den, typename T = typename V::value>
+        la::simd::basic_reductions<T> reflect_reduce(T *b, T *f, T k, std::size_t N)
+        {
+            constexpr std::size_t W = V::width;
+
+            typename V::reg kv = V::set1(k);
+            typename V::reg bf_acc = V::zero(), ff_acc = V::zero(), bb_acc = V::zero();
+
+            std::size_t j = 0;
+            for (; j + W < N; j += W)
+            {
+                typename V::reg bj = V::load(&b[j]), fj = V::load(&f[j]);
+                typename V::reg bj1 = V::load(&b[j + 1]), fj1 = V::load(&f[j + 1]);
+
+                typename V::reg b_new = V::fmadd(kv, fj, bj);
+                typename V::reg f_new = V::fmadd(kv, bj, fj);
+                typename V::reg f_next = V::fmadd(kv, bj1, fj1);
+
+                V::store(&b[j], b_new);
+                V::store(&f[j], f_new);
+
+                bf_acc = V::fmadd(b_new, f_next, bf_acc);
+                if (den)
+                {
+                    ff_acc = V::fmadd(f_next, f_next, ff_acc);
+                    bb_acc = V::fmadd(b_new, b_new, bb_acc);
+                }
+            }
+
+            T bf = V::hsum(bf_acc);
+            T ff = den ? V::hsum(ff_acc) : 0;
+            T bb = den ? V::hsum(bb_acc) : 0;
+
+            // Tail, pairs starting before it have already been accumulated
+            std::size_t tail = j;
+            T b_prev = 0;
+            for (; j < N; j++)
+            {
+                T bj = b[j], fj = f[j];
+
+                T b_new = V::fmadd1(k, fj, bj);
+                T f_new = V::fmadd1(k, bj, fj);
+
+                b[j] = b_new;
+                f[j] = f_new;
+
+                if (j > tail)
+                {
+                    bf = V::fmadd1(b_prev, f_new, bf);
+                    if (den)
+                    {
+                        ff = V::fmadd1(f_new, f_new, ff);
+                        bb = V::fmadd1(b_prev, b_prev, bb);
+                    }
+                }
+
+                b_prev = b_new;
+            }
+
+            return {bf, ff, bb};
+        }
+
+        // Error-free transformations on whole lanes, see precise_la
+
+        template <typename V>
+        inline void two_sum(typename V::reg a, typename V::reg b, typename V::reg &r, typename V::reg &e)
+        {
+            r = V::add(a, b);
+            typename V::reg z = V::sub(r, a);
+            e = V::add(V::sub(a, V::sub(r, z)), V::sub(b, z));
+        }
+
+        template <typename V, typename T = typename V::value>
+        inline void two_sum1(T a, T b, T &r, T &e)
+        {
+            r = a + b;
+            T z = r - a;
+            e = (a - (r - z)) + (b - z);
+        }
+
+        // sum_pair_elements(sum_pairs({x, 0}, two_product_FMA(k, y))) of the compensated estimators
+        template <typename V>
+        inline typename V::reg axpy_2(typename V::reg x, typename V::reg k, typename V::reg y)
+        {
+            typename V::reg p = V::mul(k, y);
+            typename V::reg q = V::add(p, V::prod_err(k, y, p));
+            typename V::reg r, e;
+
+            two_sum<V>(V::add(x, V::zero()), q, r, e);
+
+            return V::add(r, e);
+        }
+
+        template <typename V, typename T = typename V::value>
+        inline T axpy_2_1(T x, T k, T y)
+        {
+            T p = k * y;
+            T q = p + V::prod_err1(k, y, p);
+            T r, e;
+
+            two_sum1<V>(x + 0, q, r, e);
+
+            return r + e;
+        }
+
+        // One step of Dot2 on whole lanes: [p, s] += x * y
+        template <typename V>
+        inline void dot_2_step(typename V::reg x, typename V::reg y, typename V::reg &p, typename V::reg &s)
+        {
+            typename V::reg h = V::mul(x, y);
+            typename V::reg r = V::prod_err(x, y, h);
+            typename V::reg q;
+
+            two_sum<V>(p, h, p, q);
+            s = V::add(s, V::add(q, r));
+        }
+
+        template <typename V, typename T = typename V::value>
+        inline void dot_2_step1(T x, T y, T &p, T &s)
+        {
+            T h = x * y;
+            T r = V::prod_err1(x, y, h);
+            T q;
+
+            two_sum1<V>(p, h, p, q);
+            s = s + (q + r);
+        }
+
+        // Merges the [p, s] of the lanes with TwoSum
+        template <typename V, typename T = typename V::value>
+        inline la::simd::basic_compensated<T> merge_2(typename V::reg p, typename V::reg s)
+        {
+            constexpr std::size_t W = V::width;
+
+            T lanes_p[W], lanes_s[W];
+            V::store(lanes_p, p);
+            V::store(lanes_s, s);
+
+            T res = lanes_p[0], err = lanes_s[0], q;
+            for (std::size_t l = 1; l < W; l++)
+            {
+                two_sum1<V>(res, lanes_p[l], res, q);
+                err = err + (q + lanes_s[l]);
+            }
+
+            return {res, err};
+        }
+
+        // Dot2 where every lane accumulates its own [p, s], the lanes are then merged with TwoSum
+        template <typename V, typename T = typename V::value>
+        la::simd::basic_compensated<T> dot_2(const T *x, const T *y, std::size_t N)
+        {
+            constexpr std::size_t W = V::width;
+
+            typename V::reg p = V::zero(), s = V::zero();
+
+            std::size_t j = 0;
+            for (; j + W <= N; j += W)
+            {
+                dot_2_step<V>(V::load(&x[j]), V::load(&y[j]), p, s);
+            }
+
+            la::simd::basic_compensated<T> r = merge_2<V>(p, s);
+
+            for (; j < N; j++)
+            {
+                dot_2_step1<V>(x[j], y[j], r.result, r.error);
+            }
+
+            return r;
+        }
+
+        template <typename V, typename T = typename V::value>
+        void reflect_2(T *b, T *f, T k, std::size_t N)
+        {
+            constexpr std::size_t W = V::width;
+
+            typename V::reg kv = V::set1(k);
+
+            std::size_t j = 0;
+            for (; j + W <= N; j += W)
+            {
+                typename V::reg bj = V::load(&b[j]), fj = V::load(&f[j]);
+
+                V::store(&b[j], axpy_2<V>(bj, kv, fj));
+                V::store(&f[j], axpy_2<V>(fj, kv, bj));
+            }
+
+            for (; j < N; j++)
+            {
+                T bj = b[j], fj = f[j];
+
+                b[j] = axpy_2_1<V>(bj, k, fj);
+                f[j] = axpy_2_1<V>(fj, k, bj);
+            }
+        }
+
+        // Every sum of the error metrics in a single pass, two sets of accumulators
+        template <typename V, typename T = typename V::value>
+        la::simd::basic_error_sums<T> error_sums(const T *x, const T *y, std::size_t N)
+        {
+            constexpr std::size_t W = V::width;
+
+            typename V::reg abs0 = V::zero(), sq0 = V::zero(), max0 = V::zero(), signal0 = V::zero();
+            typename V::reg abs1 = V::zero(), sq1 = V::zero(), max1 = V::zero(), signal1 = V::zero();
+
+            std::size_t j = 0;
+            for (; j + 2 * W <= N; j += 2 * W)
+            {
+                typename V::reg x0 = V::load(&x[j]), x1 = V::load(&x[j + W]);
+                typename V::reg e0 = V::sub(V::load(&y[j]), x0), e1 = V::sub(V::load(&y[j + W]), x1);
+                typename V::reg a0 = V::abs(e0), a1 = V::abs(e1);
+
+                abs0 = V::add(abs0, a0);
+                sq0 = V::fmadd(e0, e0, sq0);
+                max0 = V::max(max0, a0);
+                signal0 = V::fmadd(x0, x0, signal0);
+                abs1 = V::add(abs1, a1);
+                sq1 = V::fmadd(e1, e1, sq1);
+                max1 = V::max(max1, a1);
+                signal1 = V::fmadd(x1, x1, signal1);
+            }
+
+            la::simd::basic_error_sums<T> r{V::hsum(V::add(abs0, abs1)), V::hsum(V::add(sq0, sq1)), V::hmax(V::max(max0, max1)), V::hsum(V::add(signal0, signal1))};
+
+            for (; j < N; j++)
+            {
+                T e = y[j] - x[j];
+                T a = e < 0 ? -e : e;
+
+                r.abs = r.abs + a;
+                r.sq = V::fmadd1(e, e, r.sq);
+                r.max_abs = a > r.max_abs ? a : r.max_abs;
+                r.signal = V::fmadd1(x[j], x[j], r.signal);
+            }
+
+            return r;
+        }
+
+        // Vertical kernels: each group of W windows is a register, the lanes that do not fill
+        // a register are computed one at a time. Two sets of accumulators, for even and odd elements
+
+        template <typename V, typename T = typename V::value>
+        void batch_dot_3(const T *b, const T *f, std::size_t N, std::size_t lanes, T *bf, T *ff, T *bb)
+        {
+            constexpr std::size_t W = V::width;
+
+            std::size_t g = 0;
+            for (; g + W <= lanes; g += W)
+            {
+                typename V::reg bf0 = V::zero(), ff0 = V::zero(), bb0 = V::zero();
+                typename V::reg bf1 = V::zero(), ff1 = V::zero(), bb1 = V::zero();
+
+                std::size_t j = 0;
+                for (; j + 2 <= N; j += 2)
+                {
+                    typename V::reg b0 = V::load(&b[j * lanes + g]), f0 = V::load(&f[j * lanes + g]);
+                    typename V::reg b1 = V::load(&b[(j + 1) * lanes + g]), f1 = V::load(&f[(j + 1) * lanes + g]);
+
+                    bf0 = V::fmadd(b0, f0, bf0);
+                    ff0 = V::fmadd(f0, f0, ff0);
+                    bb0 = V::fmadd(b0, b0, bb0);
+                    bf1 = V::fmadd(b1, f1, bf1);
+                    ff1 = V::fmadd(f1, f1, ff1);
+                    bb1 = V::fmadd(b1, b1, bb1);
+                }
+                if (j < N)
+                {
+                    typename V::reg b0 = V::load(&b[j * lanes + g]), f0 = V::load(&f[j * lanes + g]);
+
+                    bf0 = V::fmadd(b0, f0, bf0);
+                    ff0 = V::fmadd(f0, f0, ff0);
+                    bb0 = V::fmadd(b0, b0, bb0);
+                }
+
+                V::store(&bf[g], V::add(bf0, bf1));
+                V::store(&ff[g], V::add(ff0, ff1));
+                V::store(&bb[g], V::add(bb0, bb1));
+            }
+
+            // Remaining lanes, row by row
+            std::size_t rest = lanes - g;
+            T bf_l[W] = {}, ff_l[W] = {}, bb_l[W] = {};
+
+            for (std::size_t j = 0; j < N && rest > 0; j++)
+            {
+                const T *bj = &b[j * lanes + g], *fj = &f[j * lanes + g];
+
+                for (std::size_t l = 0; l < rest; l++)
+                {
+                    bf_l[l] = V::fmadd1(bj[l], fj[l], bf_l[l]);
+                    ff_l[l] = V::fmadd1(fj[l], fj[l], ff_l[l]);
+                    bb_l[l] = V::fmadd1(bj[l], bj[l], bb_l[l]);
+                }
+            }
+
+            for (std::size_t l = 0; l < rest; l++)
+            {
+                bf[g + l] = bf_l[l];
+                ff[g + l] = ff_l[l];
+                bb[g + l] = bb_l[l];
+            }
+        }
+
+        template <typename V, typename T = typename V::value>
+        void batch_reflect_dot_3(T *b, T *f, const T *k, std::size_t N, std::size_t lanes, T *bf, T *ff, T *bb)
+        {
+            constexpr std::size_t W = V::width;
+
+            if (N == 0)
+            {
+                for (std::size_t l = 0; l < lanes; l++)
+                {
+                    bf[l] = ff[l] = bb[l] = 0;
+                }
+                return;
+            }
+
+            std::size_t g = 0;
+            for (; g + W <= lanes; g += W)
+            {
+                typename V::reg kv = V::load(&k[g]);
+                typename V::reg bf0 = V::zero(), ff0 = V::zero(), bb0 = V::zero();
+                typename V::reg bf1 = V::zero(), ff1 = V::zero(), bb1 = V::zero();
+
+                // The first element has no predecessor
+                typename V::reg b_first = V::load(&b[g]), f_first = V::load(&f[g]);
+                typename V::reg b_prev = V::fmadd(kv, f_first, b_first);
+                V::store(&f[g], V::fmadd(kv, b_first, f_first));
+                V::store(&b[g], b_prev);
+
+                std::size_t j = 1;
+                for (; j + 2 <= N; j += 2)
+                {
+                    typename V::reg b0 = V::load(&b[j * lanes + g]), f0 = V::load(&f[j * lanes + g]);
+                    typename V::reg b1 = V::load(&b[(j + 1) * lanes + g]), f1 = V::load(&f[(j + 1) * lanes + g]);
+
+                    typename V::reg b0_new = V::fmadd(kv, f0, b0), f0_new = V::fmadd(kv, b0, f0);
+                    typename V::reg b1_new = V::fmadd(kv, f1, b1), f1_new = V::fmadd(kv, b1, f1);
+
+                    V::store(&b[j * lanes + g], b0_new);
+                    V::store(&f[j * lanes + g], f0_new);
+                    V::store(&b[(j + 1) * lanes + g], b1_new);
+                    V::store(&f[(j + 1) * lanes + g], f1_new);
+
+                    bf0 = V::fmadd(b_prev, f0_new, bf0);
+                    ff0 = V::fmadd(f0_new, f0_new, ff0);
+                    bb0 = V::fmadd(b_prev, b_prev, bb0);
+                    bf1 = V::fmadd(b0_new, f1_new, bf1);
+                    ff1 = V::fmadd(f1_new, f1_new, ff1);
+                    bb1 = V::fmadd(b0_new, b0_new, bb1);
+
+                    b_prev = b1_new;
+                }
+                if (j < N)
+                {
+                    typename V::reg b0 = V::load(&b[j * lanes + g]), f0 = V::load(&f[j * lanes + g]);
+
+                    typename V::reg b0_new = V::fmadd(kv, f0, b0), f0_new = V::fmadd(kv, b0, f0);
+
+                    V::store(&b[j * lanes + g], b0_new);
+                    V::store(&f[j * lanes + g], f0_new);
+
+                    bf0 = V::fmadd(b_prev, f0_new, bf0);
+                    ff0 = V::fmadd(f0_new, f0_new, ff0);
+                    bb0 = V::fmadd(b_prev, b_prev, bb0);
+                }
+
+                V::store(&bf[g], V::add(bf0, bf1));
+                V::store(&ff[g], V::add(ff0, ff1));
+                V::store(&bb[g], V::add(bb0, bb1));
+            }
+
+            // Remaining lanes, row by row
+            std::size_t rest = lanes - g;
+            T bf_l[W] = {}, ff_l[W] = {}, bb_l[W] = {};
+
+            for (std::size_t l = 0; l < rest; l++)
+            {
+                T b0 = b[g + l];
+                b[g + l] = V::fmadd1(k[g + l], f[g + l], b0);
+                f[g + l] = V::fmadd1(k[g + l], b0, f[g + l]);
+            }
+
+            for (std::size_t j = 1; j < N && rest > 0; j++)
+            {
+                T *bj = &b[j * lanes + g], *fj = &f[j * lanes + g];
+                const T *b_prev = bj - lanes; // Already updated
+
+                for (std::size_t l = 0; l < rest; l++)
+                {
+                    T b_old = bj[l], f_old = fj[l];
+
+                    T b_new = V::fmadd1(k[g + l], f_old, b_old);
+                    T f_new = V::fmadd1(k[g + l], b_old, f_old);
+
+                    bj[l] = b_new;
+                    fj[l] = f_new;
+
+                    bf_l[l] = V::fmadd1(b_prev[l], f_new, bf_l[l]);
+                    ff_l[l] = V::fmadd1(f_new, f_new, ff_l[l]);
+                    bb_l[l] = V::fmadd1(b_prev[l], b_prev[l], bb_l[l]);
+                }
+            }
+
+            for (std::size_t l = 0; l < rest; l++)
+            {
+                bf[g + l] = bf_l[l];
+                ff[g + l] = ff_l[l];
+                bb[g + l] = bb_l[l];
+            }
+        }
+
+        template <typename V, typename T = typename V::value>
+        T reflect_dot(T *b, T *f, T k, std::size_t N)
+        {
+            return reflect_reduce<V, false>(b, f, k, N).bf;
+        }
+
+        template <typename V, typename T = typename V::value>
+        la::simd::basic_reductions<T> reflect_dot_3(T *b, T *f, T k, std::size_t N)
+        {
+            return reflect_reduce<V, true>(b, f, k, N);
+        }
+
+        // Widening kernels: the arrays are stored as V::narrow and every operation is computed in V::value.
+        // The updated errors are rounded to V::narrow when stored and the reductions use the rounded values
+
+        template <typename V, typename S = typename V::narrow, typename T = typename V::value>
+        T widening_dot(const S *x, const S *y, std::size_t N)
+        {
+            constexpr std::size_t W = V::width;
+
+            typename V::reg acc0 = V::zero(), acc1 = V::zero(), acc2 = V::zero(), acc3 = V::zero();
+
+            std::size_t j = 0;
+            for (; j + 4 * W <= N; j += 4 * W)
+            {
+                acc0 = V::fmadd(V::load_narrow(&x[j]), V::load_narrow(&y[j]), acc0);
+                acc1 = V::fmadd(V::load_narrow(&x[j + W]), V::load_narrow(&y[j + W]), acc1);
+                acc2 = V::fmadd(V::load_narrow(&x[j + 2 * W]), V::load_narrow(&y[j + 2 * W]), acc2);
+                acc3 = V::fmadd(V::load_narrow(&x[j + 3 * W]), V::load_narrow(&y[j + 3 * W]), acc3);
+            }
+            for (; j + W <= N; j += W)
+            {
+                acc0 = V::fmadd(V::load_narrow(&x[j]), V::load_narrow(&y[j]), acc0);
+            }
+
+            T r = V::hsum(V::add(V::add(acc0, acc1), V::add(acc2, acc3)));
+
+            for (; j < N; j++)
+            {
+                r = V::fmadd1(x[j], y[j], r);
+            }
+
+            return r;
+        }
+
+        template <typename V, typename S = typename V::narrow, typename T = typename V::value>
+        la::simd::basic_reductions<T> widening_dot_3(const S *b, const S *f, std::size_t N)
+        {
+            constexpr std::size_t W = V::width;
+
+            typename V::reg bf0 = V::zero(), ff0 = V::zero(), bb0 = V::zero();
+            typename V::reg bf1 = V::zero(), ff1 = V::zero(), bb1 = V::zero();
+
+            std::size_t j = 0;
+            for (; j + 2 * W <= N; j += 2 * W)
+            {
+                typename V::reg b0 = V::load_narrow(&b[j]), f0 = V::load_narrow(&f[j]);
+                typename V::reg b1 = V::load_narrow(&b[j + W]), f1 = V::load_narrow(&f[j + W]);
+
+                bf0 = V::fmadd(b0, f0, bf0);
+                ff0 = V::fmadd(f0, f0, ff0);
+                bb0 = V::fmadd(b0, b0, bb0);
+                bf1 = V::fmadd(b1, f1, bf1);
+                ff1 = V::fmadd(f1, f1, ff1);
+                bb1 = V::fmadd(b1, b1, bb1);
+            }
+
+            T bf = V::hsum(V::add(bf0, bf1));
+            T ff = V::hsum(V::add(ff0, ff1));
+            T bb = V::hsum(V::add(bb0, bb1));
+
+            for (; j < N; j++)
+            {
+                T bj = b[j], fj = f[j];
+
+                bf = V::fmadd1(bj, fj, bf);
+                ff = V::fmadd1(fj, fj, ff);
+                bb = V::fmadd1(bj, bj, bb);
+            }
+
+            return {bf, ff, bb};
+        }
+
+        template <typename V, typename S = typename V::narrow, typename T = typename V::value>
+        void widening_reflect(S *b, S *f, T k, std::size_t N)
+        {
+            constexpr std::size_t W = V::width;
+
+            typename V::reg kv = V::set1(k);
+
+            std::size_t j = 0;
+            for (; j + W <= N; j += W)
+            {
+                typename V::reg bj = V::load_narrow(&b[j]), fj = V::load_narrow(&f[j]);
+
+                V::store_narrow(&b[j], V::to_narrow(V::fmadd(kv, fj, bj)));
+                V::store_narrow(&f[j], V::to_narrow(V::fmadd(kv, bj, fj)));
+            }
+
+            for (; j < N; j++)
+            {
+                T bj = b[j], fj = f[j];
+
+                b[j] = static_cast<S>(V::fmadd1(k, fj, bj));
+                f[j] = static_cast<S>(V::fmadd1(k, bj, fj));
+            }
+        }
+
+        // Unlike reflect_reduce, the f[m + 1 .. m + W] of a block are not recomputed, the conversions would
+        // cost more than the update: the pairs of a block are accumulated once the next one is updated,
+        // shifting its first f in. The pairs of the last full block are accumulated with the tail
+        template <typename V, bool den, typename S = typename V::narrow, typename T = typename V::value>
+        la::simd::basic_reductions<T> widening_reflect_reduce(S *b, S *f, T k, std::size_t N)
+        {
+            constexpr std::size_t W = V::width;
+
+            typename V::reg kv = V::set1(k);
+            typename V::reg bf_acc = V::zero(), ff_acc = V::zero(), bb_acc = V::zero();
+            typename V::reg b_prev = V::zero(), f_prev = V::zero();
+
+            std::size_t j = 0;
+            for (; j + W <= N; j += W)
+            {
+                typename V::reg bj = V::load_narrow(&b[j]), fj = V::load_narrow(&f[j]);
+
+                // Rounded once, the stored values are the accumulated ones
+                typename V::narrow_reg b_narrow = V::to_narrow(V::fmadd(kv, fj, bj));
+                typename V::narrow_reg f_narrow = V::to_narrow(V::fmadd(kv, bj, fj));
+
+                V::store_narrow(&b[j], b_narrow);
+                V::store_narrow(&f[j], f_narrow);
+
+                typename V::reg b_new = V::widen(b_narrow);
+                typename V::reg f_new = V::widen(f_narrow);
+
+                if (j > 0)
+                {
+                    typename V::reg f_next = V::shift_in(f_prev, f_new);
+
+                    bf_acc = V::fmadd(b_prev, f_next, bf_acc);
+                    if (den)
+                    {
+                        ff_acc = V::fmadd(f_next, f_next, ff_acc);
+                        bb_acc = V::fmadd(b_prev, b_prev, bb_acc);
+                    }
+                }
+
+                b_prev = b_new;
+                f_prev = f_new;
+            }
+
+            T bf = V::hsum(bf_acc);
+            T ff = den ? V::hsum(ff_acc) : 0;
+            T bb = den ? V::hsum(bb_acc) : 0;
+
+            // Pairs of the last full block, on the stored values
+            for (std::size_t m = j - (j > 0 ? W : 0); m + 1 < j; m++)
+            {
+                T bm = b[m], fm = f[m + 1];
+
+                bf = V::fmadd1(bm, fm, bf);
+                if (den)
+                {
+                    ff = V::fmadd1(fm, fm, ff);
+                    bb = V::fmadd1(bm, bm, bb);
+                }
+            }
+
+            // Tail, paired with the last element of the blocks
+            T b_last = j > 0 ? T(b[j - 1]) : 0;
+            for (; j < N; j++)
+            {
+                T bj = b[j], fj = f[j];
+
+                S b_new = static_cast<S>(V::fmadd1(k, fj, bj));
+                S f_new = static_cast<S>(V::fmadd1(k, bj, fj));
+
+                b[j] = b_new;
+                f[j] = f_new;
+
+                if (j > 0)
+                {
+                    bf = V::fmadd1(b_last, f_new, bf);
+                    if (den)
+                    {
+                        ff = V::fmadd1(f_new, f_new, ff);
+                        bb = V::fmadd1(b_last, b_last, bb);
+                    }
+                }
+
+                b_last = b_new;
+            }
+
+            return {bf, ff, bb};
+        }
+
+        template <typename V, typename S = typename V::narrow, typename T = typename V::value>
+        T widening_reflect_dot(S *b, S *f, T k, std::size_t N)
+        {
+            return widening_reflect_reduce<V, false>(b, f, k, N).bf;
+        }
+
+        template <typename V, typename S = typename V::narrow, typename T = typename V::value>
+        la::simd::basic_reductions<T> widening_reflect_dot_3(S *b, S *f, T k, std::size_t N)
+        {
+            return widening_reflect_reduce<V, true>(b, f, k, N);
+        }
+
+        // Compensated kernels: the arrays are stored as V::value, the reductions are accumulated with Dot2 and the
+        // reflection coefficient is compensated too, k = [result, error]. Used for the double-double accumulators
+
+        // x + k * y, rounded once: TwoProduct of the result of k and TwoSum with x, the error of k on top
+        template <typename V>
+        inline typename V::reg axpy_k(typename V::reg x, typename V::reg k, typename V::reg k_err, typename V::reg y)
+        {
+            typename V::reg p = V::mul(k, y);
+            typename V::reg e = V::fmadd(k_err, y, V::prod_err(k, y, p));
+            typename V::reg r, q;
+
+            two_sum<V>(x, p, r, q);
+
+            return V::add(r, V::add(q, e));
+        }
+
+        template <typename V, typename T = typename V::value>
+        inline T axpy_k1(T x, T k, T k_err, T y)
+        {
+            T p = k * y;
+            T e = V::fmadd1(k_err, y, V::prod_err1(k, y, p));
+            T r, q;
+
+            two_sum1<V>(x, p, r, q);
+
+            return r + (q + e);
+        }
+
+        template <typename V, typename T = typename V::value>
+        la::simd::basic_reductions<la::simd::basic_compensated<T>> compensated_dot_3(const T *b, const T *f, std::size_t N)
+        {
+            constexpr std::size_t W = V::width;
+
+            typename V::reg bf_p = V::zero(), bf_s = V::zero();
+            typename V::reg ff_p = V::zero(), ff_s = V::zero();
+            typename V::reg bb_p = V::zero(), bb_s = V::zero();
+
+            std::size_t j = 0;
+            for (; j + W <= N; j += W)
+            {
+                typename V::reg bj = V::load(&b[j]), fj = V::load(&f[j]);
+
+                dot_2_step<V>(bj, fj, bf_p, bf_s);
+                dot_2_step<V>(fj, fj, ff_p, ff_s);
+                dot_2_step<V>(bj, bj, bb_p, bb_s);
+            }
+
+            la::simd::basic_reductions<la::simd::basic_compensated<T>> r{merge_2<V>(bf_p, bf_s), merge_2<V>(ff_p, ff_s), merge_2<V>(bb_p, bb_s)};
+
+            for (; j < N; j++)
+            {
+                dot_2_step1<V>(b[j], f[j], r.bf.result, r.bf.error);
+                dot_2_step1<V>(f[j], f[j], r.ff.result, r.ff.error);
+                dot_2_step1<V>(b[j], b[j], r.bb.result, r.bb.error);
+            }
+
+            return r;
+        }
+
+        template <typename V, typename T = typename V::value>
+        void compensated_reflect(T *b, T *f, la::simd::basic_compensated<T> k, std::size_t N)
+        {
+            constexpr std::size_t W = V::width;
+
+            typename V::reg kv = V::set1(k.result), kv_err = V::set1(k.error);
+
+            std::size_t j = 0;
+            for (; j + W <= N; j += W)
+            {
+                typename V::reg bj = V::load(&b[j]), fj = V::load(&f[j]);
+
+                V::store(&b[j], axpy_k<V>(bj, kv, kv_err, fj));
+                V::store(&f[j], axpy_k<V>(fj, kv, kv_err, bj));
+            }
+
+            for (; j < N; j++)
+            {
+                T bj = b[j], fj = f[j];
+
+                b[j] = axpy_k1<V>(bj, k.result, k.error, fj);
+                f[j] = axpy_k1<V>(fj, k.result, k.error, bj);
+            }
+        }
+
+        // See widening_reflect_reduce, the pairs of a block are accumulated once the next one is updated
+        template <typename V, bool den, typename T = typename V::value>
+        la::simd::basic_reductions<la::simd::basic_compensated<T>> compensated_reflect_reduce(T *b, T *f, la::simd::basic_compensated<T> k, std::size_t N)
+        {
+            constexpr std::size_t W = V::width;
+
+            typename V::reg kv = V::set1(k.result), kv_err = V::set1(k.error);
+            typename V::reg bf_p = V::zero(), bf_s = V::zero();
+            typename V::reg ff_p = V::zero(), ff_s = V::zero();
+            typename V::reg bb_p = V::zero(), bb_s = V::zero();
+            typename V::reg b_prev = V::zero(), f_prev = V::zero();
+
+            std::size_t j = 0;
+            for (; j + W <= N; j += W)
+            {
+                typename V::reg bj = V::load(&b[j]), fj = V::load(&f[j]);
+
+                typename V::reg b_new = axpy_k<V>(bj, kv, kv_err, fj);
+                typename V::reg f_new = axpy_k<V>(fj, kv, kv_err, bj);
+
+                V::store(&b[j], b_new);
+                V::store(&f[j], f_new);
+
+                if (j > 0)
+                {
+                    typename V::reg f_next = V::shift_in(f_prev, f_new);
+
+                    dot_2_step<V>(b_prev, f_next, bf_p, bf_s);
+                    if (den)
+                    {
+                        dot_2_step<V>(f_next, f_next, ff_p, ff_s);
+                        dot_2_step<V>(b_prev, b_prev, bb_p, bb_s);
+                    }
+                }
+
+                b_prev = b_new;
+                f_prev = f_new;
+            }
+
+            la::simd::basic_reductions<la::simd::basic_compensated<T>> r{merge_2<V>(bf_p, bf_s), {0, 0}, {0, 0}};
+            if (den)
+            {
+                r.ff = merge_2<V>(ff_p, ff_s);
+                r.bb = merge_2<V>(bb_p, bb_s);
+            }
+
+            // Pairs of the last full block
+            for (std::size_t m = j - (j > 0 ? W : 0); m + 1 < j; m++)
+            {
+                dot_2_step1<V>(b[m], f[m + 1], r.bf.result, r.bf.error);
+                if (den)
+                {
+                    dot_2_step1<V>(f[m + 1], f[m + 1], r.ff.result, r.ff.error);
+                    dot_2_step1<V>(b[m], b[m], r.bb.result, r.bb.error);
+                }
+            }
+
+            // Tail, paired with the last element of the blocks
+            T b_last = j > 0 ? b[j - 1] : 0;
+            for (; j < N; j++)
+            {
+                T bj = b[j], fj = f[j];
+
+                T b_new = axpy_k1<V>(bj, k.result, k.error, fj);
+                T f_new = axpy_k1<V>(fj, k.result, k.error, bj);
+
+                b[j] = b_new;
+                f[j] = f_new;
+
+                if (j > 0)
+                {
+                    dot_2_step1<V>(b_last, f_new, r.bf.result, r.bf.error);
+                    if (den)
+                    {
+                        dot_2_step1<V>(f_new, f_new, r.ff.result, r.ff.error);
+                        dot_2_step1<V>(b_last, b_last, r.bb.result, r.bb.error);
+                    }
+                }
+
+                b_last = b_new;
+            }
+
+            return r;
+        }
+
+        template <typename V, typename T = typename V::value>
+        la::simd::basic_compensated<T> compensated_reflect_dot(T *b, T *f, la::simd::basic_compensated<T> k, std::size_t N)
+        {
+            return compensated_reflect_reduce<V, false>(b, f, k, N).bf;
+        }
+
+        template <typename V, typename T = typename V::value>
+        la::simd::basic_reductions<la::simd::basic_compensated<T>> compensated_reflect_dot_3(T *b, T *f, la::simd::basic_compensated<T> k, std::size_t N)
+        {
+            return compensated_reflect_reduce<V, true>(b, f, k, N);
+        }
+    }
+}
+
+#endif
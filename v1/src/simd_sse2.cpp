@@ -0,0 +1,198 @@
+#include <emmintrin.h>
+#include "simd_kernels.hpp"
+
+namespace
+{
+    struct sse2_ops
+    {
+        using value = double;
+        using narrow = float;
+        using narrow_reg = __m128; // The low width lanes
+        using reg = __m128d;
+        static constexpr std::size_t width = 2;
+
+        static inline reg zero() { return _mm_setzero_pd(); }
+        static inline reg set1(double x) { return _mm_set1_pd(x); }
+        static inline reg load(const double *p) { return _mm_loadu_pd(p); }
+        static inline void store(double *p, reg v) { _mm_storeu_pd(p, v); }
+        static inline reg load_narrow(const float *p) { return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)))); }
+        static inline void store_narrow(float *p, narrow_reg v) { _mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_castps_si128(v)); }
+        static inline narrow_reg to_narrow(reg v) { return _mm_cvtpd_ps(v); }
+        static inline reg widen(narrow_reg v) { return _mm_cvtps_pd(v); }
+        static inline reg shift_in(reg a, reg b) { return _mm_shuffle_pd(a, b, 1); }
+        static inline reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+        static inline reg mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+        static inline reg fmadd(reg a, reg b, reg c) { return _mm_add_pd(_mm_mul_pd(a, b), c); } // No FMA in SSE2
+        static inline double fmadd1(double a, double b, double c) { return a * b + c; }
+        static inline reg sub(reg a, reg b) { return _mm_sub_pd(a, b); }
+        static inline reg abs(reg v) { return _mm_andnot_pd(_mm_set1_pd(-0.0), v); }
+        static inline reg max(reg a, reg b) { return _mm_max_pd(a, b); }
+
+        // Dekker's TwoProduct (Veltkamp's split) since there is no FMA to get the exact error
+        static inline void split(reg a, reg &hi, reg &lo)
+        {
+            reg c = _mm_mul_pd(_mm_set1_pd(134217729.0), a); // 2^27 + 1
+            hi = _mm_sub_pd(c, _mm_sub_pd(c, a));
+            lo = _mm_sub_pd(a, hi);
+        }
+
+        static inline reg prod_err(reg a, reg b, reg p)
+        {
+            reg a_hi, a_lo, b_hi, b_lo;
+            split(a, a_hi, a_lo);
+            split(b, b_hi, b_lo);
+
+            return _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_sub_pd(_mm_mul_pd(a_hi, b_hi), p), _mm_mul_pd(a_hi, b_lo)), _mm_mul_pd(a_lo, b_hi)), _mm_mul_pd(a_lo, b_lo));
+        }
+
+        static inline double prod_err1(double a, double b, double p)
+        {
+            return _mm_cvtsd_f64(prod_err(_mm_set_sd(a), _mm_set_sd(b), _mm_set_sd(p)));
+        }
+
+        static inline double hsum(reg v)
+        {
+            double lanes[width];
+            _mm_storeu_pd(lanes, v);
+
+            return lanes[0] + lanes[1];
+        }
+
+        static inline double hmax(reg v)
+        {
+            double lanes[width];
+            _mm_storeu_pd(lanes, v);
+
+            double r = lanes[0];
+            for (std::size_t i = 1; i < width; i++)
+            {
+                r = lanes[i] > r ? lanes[i] : r;
+            }
+
+            return r;
+        }
+    };
+
+    struct sse2_ops_float
+    {
+        using value = float;
+        using reg = __m128;
+        static constexpr std::size_t width = 4;
+
+        static inline reg zero() { return _mm_setzero_ps(); }
+        static inline reg set1(float x) { return _mm_set1_ps(x); }
+        static inline reg load(const float *p) { return _mm_loadu_ps(p); }
+        static inline void store(float *p, reg v) { _mm_storeu_ps(p, v); }
+        static inline reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+        static inline reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+        static inline reg fmadd(reg a, reg b, reg c) { return _mm_add_ps(_mm_mul_ps(a, b), c); } // No FMA in SSE2
+        static inline float fmadd1(float a, float b, float c) { return a * b + c; }
+        static inline reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+        static inline reg abs(reg v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+        static inline reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+
+        static inline void split(reg a, reg &hi, reg &lo)
+        {
+            reg c = _mm_mul_ps(_mm_set1_ps(4097.0f), a); // 2^12 + 1
+            hi = _mm_sub_ps(c, _mm_sub_ps(c, a));
+            lo = _mm_sub_ps(a, hi);
+        }
+
+        static inline reg prod_err(reg a, reg b, reg p)
+        {
+            reg a_hi, a_lo, b_hi, b_lo;
+            split(a, a_hi, a_lo);
+            split(b, b_hi, b_lo);
+
+            return _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(a_hi, b_hi), p), _mm_mul_ps(a_hi, b_lo)), _mm_mul_ps(a_lo, b_hi)), _mm_mul_ps(a_lo, b_lo));
+        }
+
+        static inline float prod_err1(float a, float b, float p)
+        {
+            return _mm_cvtss_f32(prod_err(_mm_set_ss(a), _mm_set_ss(b), _mm_set_ss(p)));
+        }
+
+        static inline float hsum(reg v)
+        {
+            float lanes[width];
+            _mm_storeu_ps(lanes, v);
+
+            return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        }
+
+        static inline float hmax(reg v)
+        {
+            float lanes[width];
+            _mm_storeu_ps(lanes, v);
+
+            float r = lanes[0];
+            for (std::size_t i = 1; i < width; i++)
+            {
+                r = lanes[i] > r ? lanes[i] : r;
+            }
+
+            return r;
+        }
+    };
+}
+
+namespace la
+{
+    namespace simd
+    {
+        extern const kernel_table sse2_kernels;
+        extern const basic_kernel_table<float> sse2_kernels_float;
+        extern const widening_table sse2_kernels_widening;
+        extern const compensated_widening_table sse2_kernels_compensated;
+
+        const kernel_table sse2_kernels{
+            isa::SSE2,
+            "sse2",
+            &kernels::dot<sse2_ops>,
+            &kernels::dot_3<sse2_ops>,
+            &kernels::reflect<sse2_ops>,
+            &kernels::reflect_dot<sse2_ops>,
+            &kernels::reflect_dot_3<sse2_ops>,
+            &kernels::dot_2<sse2_ops>,
+            &kernels::reflect_2<sse2_ops>,
+            &kernels::batch_dot_3<sse2_ops>,
+            &kernels::batch_reflect_dot_3<sse2_ops>,
+            &kernels::error_sums<sse2_ops>,
+        };
+
+        const basic_kernel_table<float> sse2_kernels_float{
+            isa::SSE2,
+            "sse2",
+            &kernels::dot<sse2_ops_float>,
+            &kernels::dot_3<sse2_ops_float>,
+            &kernels::reflect<sse2_ops_float>,
+            &kernels::reflect_dot<sse2_ops_float>,
+            &kernels::reflect_dot_3<sse2_ops_float>,
+            &kernels::dot_2<sse2_ops_float>,
+            &kernels::reflect_2<sse2_ops_float>,
+            &kernels::batch_dot_3<sse2_ops_float>,
+            &kernels::batch_reflect_dot_3<sse2_ops_float>,
+            &kernels::error_sums<sse2_ops_float>,
+        };
+
+        const widening_table sse2_kernels_widening{
+            isa::SSE2,
+            "sse2",
+            &kernels::widening_dot<sse2_ops>,
+            &kernels::widening_dot_3<sse2_ops>,
+            &kernels::widening_reflect<sse2_ops>,
+            &kernels::widening_reflect_dot<sse2_ops>,
+            &kernels::widening_reflect_dot_3<sse2_ops>,
+        };
+
+        const compensated_widening_table sse2_kernels_compensated{
+            isa::SSE2,
+            "sse2",
+            &kernels::dot_2<sse2_ops>,
+            &kernels::compensated_dot_3<sse2_ops>,
+            &kernels::compensated_reflect<sse2_ops>,
+            &kernels::compensated_reflect_dot<sse2_ops>,
+            &kernels::compensated_reflect_dot_3<sse2_ops>,
+        };
+    }
+}
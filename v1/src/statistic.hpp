@@ -3,61 +3,225 @@
 
 #include <vector>
 #include <cstdint>
-#include <random>
-#include <set>
+#include <string>
 #include <stdexcept>
 #include <cmath>
+#include <limits>
+#include <algorithm>
+#include "la.hpp"
 
 namespace stats
 {
-    static std::mt19937 gen;
+    /**
+     * @brief Counter-based generator: the i-th number is the splitmix64 finalizer of key + i * golden gamma,
+     * so a stream depends only on its key and not on the numbers drawn before it by anyone else.
+     * The key is derived from a seed and a name (e.g. the path of a file), so every file has its own
+     * stream, identical whatever the order or the process the files are handled in.
+     * It is a UniformRandomBitGenerator, usable with the distributions of <random>
+     */
+    class counter_rng
+    {
+    private:
+        uint64_t key;
+        uint64_t counter{0};
+
+        static uint64_t mix(uint64_t z)
+        {
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+    public:
+        using result_type = uint64_t;
+
+        /**
+         * @brief Stream of the name (FNV-1a hashed) under the seed
+         */
+        counter_rng(uint64_t seed, const std::string &name)
+        {
+            uint64_t h = 0xCBF29CE484222325ull;
+            for (unsigned char c : name)
+            {
+                h = (h ^ c) * 0x100000001B3ull;
+            }
 
-    void initialize_random(uint64_t seed)
+            key = mix(mix(seed) ^ h);
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<uint64_t>::max(); }
+
+        result_type operator()()
+        {
+            return mix(key + ++counter * 0x9E3779B97F4A7C15ull);
+        }
+
+        /**
+         * @brief Uniform in (0, 1], never 0 so that its logarithm is finite
+         */
+        double uniform()
+        {
+            return ((*this)() >> 11) * 0x1.0p-53 + 0x1.0p-53;
+        }
+    };
+
+    /**
+     * @brief Sequential random sampling, Vitter's Method D: n of the N indices [0, N) uniformly at random,
+     * without repetitions and in increasing order, in O(n) expected time and memory. Each selected index is
+     * found by drawing the number of skipped ones; Method A (O(N)) finishes when n is a large fraction of N
+     * @cite Vitter-1987
+     */
+    inline std::vector<uint64_t> sample_sorted(uint64_t N, uint64_t n, counter_rng &rng)
     {
-        gen.seed(seed);
+        std::vector<uint64_t> res;
+        res.reserve(n);
+
+        if (n == 0)
+        {
+            return res;
+        }
+
+        int64_t current = -1;
+        const double alpha_inv = 13;
+
+        double n_real = n, N_real = N;
+        double n_inv = 1 / n_real;
+        double threshold = -alpha_inv * n_real;
+        double v_prime = std::exp(std::log(rng.uniform()) * n_inv);
+        double qu1_real = N_real - n_real + 1;
+
+        // Method D
+        while (n > 1 && threshold < N_real)
+        {
+            const double n_min1_inv = 1 / (n_real - 1);
+            double X, S;
+
+            for (;;)
+            {
+                // Candidate skip, from the continuous approximation
+                for (;;)
+                {
+                    X = N_real * (1 - v_prime);
+                    S = std::floor(X);
+                    if (S < qu1_real)
+                    {
+                        break;
+                    }
+                    v_prime = std::exp(std::log(rng.uniform()) * n_inv);
+                }
+
+                const double U = rng.uniform();
+                const double y1 = std::exp(std::log(U * N_real / qu1_real) * n_min1_inv);
+                v_prime = y1 * (1 - X / N_real) * (qu1_real / (qu1_real - S));
+
+                // Quick acceptance
+                if (v_prime <= 1)
+                {
+                    break;
+                }
+
+                // Exact acceptance
+                double y2 = 1, top = N_real - 1, bottom, limit;
+                if (n_real - 1 > S)
+                {
+                    bottom = N_real - n_real;
+                    limit = N_real - S;
+                }
+                else
+                {
+                    bottom = N_real - S - 1;
+                    limit = qu1_real;
+                }
+
+                for (double t = N_real - 1; t >= limit; t--)
+                {
+                    y2 = (y2 * top) / bottom;
+                    top--;
+                    bottom--;
+                }
+
+                if (N_real / (N_real - X) >= y1 * std::exp(std::log(y2) * n_min1_inv))
+                {
+                    v_prime = std::exp(std::log(rng.uniform()) * n_min1_inv);
+                    break;
+                }
+
+                v_prime = std::exp(std::log(rng.uniform()) * n_inv);
+            }
+
+            current += static_cast<int64_t>(S) + 1;
+            res.push_back(current);
+
+            N_real = N_real - S - 1;
+            n--;
+            n_real--;
+            n_inv = n_min1_inv;
+            qu1_real = qu1_real - S;
+            threshold += alpha_inv;
+        }
+
+        if (n > 1)
+        {
+            // Method A
+            double top = N_real - n_real;
+
+            while (n >= 2)
+            {
+                const double V = rng.uniform();
+                double quot = top / N_real;
+                int64_t S = 0;
+
+                while (quot > V)
+                {
+                    S++;
+                    top--;
+                    N_real--;
+                    quot = quot * top / N_real;
+                }
+
+                current += S + 1;
+                res.push_back(current);
+                N_real--;
+                n--;
+            }
+
+            v_prime = rng.uniform();
+        }
+
+        // The last one among the N_real left, v_prime is uniform in (0, 1]
+        current += static_cast<int64_t>(std::min(std::floor(N_real * v_prime), N_real - 1)) + 1;
+        res.push_back(current);
+
+        return res;
     }
 
     /**
-     * @brief Generate n position
-     *
-     * @tparam T
-     * @param min
-     * @param max
-     * @param n
-     * @return std::vector<T>
+     * @brief Generates n distinct positions, multiples of mul_of in [min, max), in increasing order,
+     * drawn from rng
      */
     template <typename T, std::enable_if_t<true == std::is_integral<T>(), bool> = true>
-    std::vector<T> get_n_positions(uint64_t min, uint64_t max, uint64_t n, uint64_t mul_of = 1)
+    std::vector<T> get_n_positions(uint64_t min, uint64_t max, uint64_t n, counter_rng &rng, uint64_t mul_of = 1)
     {
-
         min = min + (mul_of - (min % mul_of)) % mul_of; // Minimum value needs to be a multiple of mul_of
         max = max - (max % mul_of);                     // Maximum value needs to be a multiple of mul_of
 
         uint64_t range_min = min / mul_of;
         uint64_t range_max = max / mul_of;
 
-        std::uniform_int_distribution<> distr(range_min, range_max - 1); // define the range
-
-        std::set<T> random_num_no_repetition;
-
         if (max <= min || n > range_max - range_min)
         {
             throw std::runtime_error("can not generate " + std::to_string(n) + " numbers");
         }
 
-        for (uint64_t i = 0; i < n; ++i)
+        std::vector<T> generated_numbers;
+        generated_numbers.reserve(n);
+
+        for (auto i : sample_sorted(range_max - range_min, n, rng))
         {
-            uint64_t _random_number = distr(stats::gen);
-            while (random_num_no_repetition.find(_random_number * mul_of) != random_num_no_repetition.end())
-            {
-                _random_number = (_random_number + 1 - range_min) % (range_max - range_min) + range_min;
-            }
-            random_num_no_repetition.insert(_random_number * mul_of);
+            generated_numbers.push_back((range_min + i) * mul_of);
         }
 
-        std::vector<T> generated_numbers;
-        std::copy(random_num_no_repetition.begin(), random_num_no_repetition.end(), std::back_inserter(generated_numbers));
-
         return generated_numbers;
     }
 
@@ -75,9 +239,8 @@ namespace stats
     }
 
     template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
-    T mae(const std::vector<T> &v1, const std::vector<T> &v2)
+    T mae(const T *v1, const T *v2, std::size_t n)
     {
-        std::size_t n = v1.size();
         T res{};
         for (std::size_t i = 0; i < n; i++)
         {
@@ -88,17 +251,55 @@ namespace stats
     }
 
     template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
-    T rmse(const std::vector<T> &v1, const std::vector<T> &v2, bool squared = false)
+    T mae(const std::vector<T> &v1, const std::vector<T> &v2)
+    {
+        return mae(v1.data(), v2.data(), v1.size());
+    }
+
+    template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
+    T rmse(const T *v1, const T *v2, std::size_t n, bool squared = false)
     {
-        std::size_t n = v1.size();
         T res{};
         for (std::size_t i = 0; i < n; i++)
         {
-            res += std::pow((v2[i] - v1[i]), 2);
+            T e = v2[i] - v1[i];
+            res += e * e;
         }
 
         return squared ? res / n : std::sqrt(res / n);
     }
+
+    template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
+    T rmse(const std::vector<T> &v1, const std::vector<T> &v2, bool squared = false)
+    {
+        return rmse(v1.data(), v2.data(), v1.size(), squared);
+    }
+
+    /**
+     * @brief The error metrics of the estimates v2 of v1
+     */
+    template <typename T>
+    struct error_metrics
+    {
+        T mae;
+        T mse;
+        T rmse;
+        T max_ae;
+        T snr; // 10 log10(Σv1² / Σ(v2 - v1)²) in dB, infinity if there is no error
+    };
+
+    /**
+     * @brief MAE, MSE, RMSE, max absolute error and SNR of v2 with respect to v1, in a single pass over the
+     * two arrays with the SIMD kernels in use for doubles and floats (see la::metrics), without allocating
+     */
+    template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
+    error_metrics<T> metrics(const T *v1, const T *v2, std::size_t n)
+    {
+        const auto s = la::metrics::error_sums(v1, v2, n);
+        const T mse = s.sq / n;
+
+        return {s.abs / n, mse, std::sqrt(mse), s.max_abs, s.sq > 0 ? 10 * std::log10(s.signal / s.sq) : std::numeric_limits<T>::infinity()};
+    }
 }
 
 #endif
\ No newline at end of file
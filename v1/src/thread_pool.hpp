@@ -0,0 +1,290 @@
+#ifndef __THREAD_POOL_HPP__
+#define __THREAD_POOL_HPP__
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <algorithm>
+
+namespace parallel
+{
+    /**
+     * @brief Work stealing thread pool.
+     * Every worker owns a queue: it runs its own tasks newest first and, when it has none, steals the
+     * oldest task of another worker. Tasks submitted by a worker go to its own queue, the others are
+     * spread round robin
+     */
+    class pool
+    {
+    private:
+        using task = std::function<void()>;
+
+        struct queue
+        {
+            std::mutex m;
+            std::deque<task> tasks;
+        };
+
+        std::vector<std::unique_ptr<queue>> queues;
+        std::vector<std::thread> threads;
+
+        std::mutex m;
+        std::condition_variable work_available;
+        std::condition_variable all_done;
+        std::size_t queued{0};  // Tasks in the queues not yet reserved by a worker
+        std::size_t pending{0}; // Tasks submitted and not yet completed
+        std::size_t next{0};    // Queue of the next task submitted from outside the pool
+        bool stopping{false};
+        std::exception_ptr error;
+
+        // Worker running on this thread
+        inline static thread_local const pool *owner = nullptr;
+        inline static thread_local std::size_t self = 0;
+
+        bool try_pop(std::size_t id, task &t)
+        {
+            // Own queue, newest first
+            {
+                std::lock_guard<std::mutex> lk(queues[id]->m);
+                if (!queues[id]->tasks.empty())
+                {
+                    t = std::move(queues[id]->tasks.back());
+                    queues[id]->tasks.pop_back();
+                    return true;
+                }
+            }
+
+            // Steal the oldest task of the others
+            for (std::size_t i = 1; i < queues.size(); ++i)
+            {
+                auto &victim = *queues[(id + i) % queues.size()];
+
+                std::lock_guard<std::mutex> lk(victim.m);
+                if (!victim.tasks.empty())
+                {
+                    t = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void run(std::size_t id)
+        {
+            owner = this;
+            self = id;
+
+            while (true)
+            {
+                {
+                    std::unique_lock<std::mutex> lk(m);
+                    work_available.wait(lk, [&]
+                                        { return stopping || queued > 0; });
+
+                    if (queued == 0)
+                    {
+                        return;
+                    }
+
+                    // Reserve a task, it is in one of the queues
+                    --queued;
+                }
+
+                task t;
+                while (!try_pop(id, t))
+                {
+                    std::this_thread::yield();
+                }
+
+                try
+                {
+                    t();
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lk(m);
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                }
+
+                {
+                    std::lock_guard<std::mutex> lk(m);
+                    if (--pending == 0)
+                    {
+                        all_done.notify_all();
+                    }
+                }
+            }
+        }
+
+    public:
+        /**
+         * @brief Starts n_threads workers (the number of hardware threads if 0)
+         */
+        pool(std::size_t n_threads = 0)
+        {
+            if (n_threads == 0)
+            {
+                n_threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+
+            for (std::size_t i = 0; i < n_threads; ++i)
+            {
+                queues.push_back(std::make_unique<queue>());
+            }
+
+            for (std::size_t i = 0; i < n_threads; ++i)
+            {
+                threads.emplace_back(&pool::run, this, i);
+            }
+        }
+
+        ~pool()
+        {
+            {
+                std::lock_guard<std::mutex> lk(m);
+                stopping = true;
+            }
+            work_available.notify_all();
+
+            for (auto &t : threads)
+            {
+                t.join();
+            }
+        }
+
+        pool(const pool &) = delete;
+        pool &operator=(const pool &) = delete;
+
+        void submit(task t)
+        {
+            std::size_t id;
+            {
+                std::lock_guard<std::mutex> lk(m);
+                id = owner == this ? self : next++ % queues.size();
+                ++pending;
+            }
+
+            {
+                std::lock_guard<std::mutex> lk(queues[id]->m);
+                queues[id]->tasks.push_back(std::move(t));
+            }
+
+            {
+                std::lock_guard<std::mutex> lk(m);
+                ++queued;
+            }
+            work_available.notify_one();
+        }
+
+        /**
+         * @brief Waits for every submitted task, rethrowing the first exception thrown by one of them
+         */
+        void wait()
+        {
+            std::unique_lock<std::mutex> lk(m);
+            all_done.wait(lk, [&]
+                          { return pending == 0; });
+
+            if (error)
+            {
+                std::exception_ptr e = error;
+                error = nullptr;
+                std::rethrow_exception(e);
+            }
+        }
+
+        std::size_t size() const
+        {
+            return threads.size();
+        }
+    };
+
+    /**
+     * @brief Set of tasks run on a pool that can be waited for independently of the others,
+     * e.g. all the tasks of a file
+     */
+    class task_group
+    {
+    private:
+        pool &workers;
+
+        std::mutex m;
+        std::condition_variable all_done;
+        std::size_t pending{0};
+        std::exception_ptr error;
+
+    public:
+        task_group(pool &workers) : workers{workers} {}
+
+        // The tasks refer to the group, so it lives until they are all completed
+        ~task_group()
+        {
+            std::unique_lock<std::mutex> lk(m);
+            all_done.wait(lk, [&]
+                          { return pending == 0; });
+        }
+
+        task_group(const task_group &) = delete;
+        task_group &operator=(const task_group &) = delete;
+
+        template <typename F>
+        void run(F f)
+        {
+            {
+                std::lock_guard<std::mutex> lk(m);
+                ++pending;
+            }
+
+            workers.submit([this, f]()
+                           {
+                               try
+                               {
+                                   f();
+                               }
+                               catch (...)
+                               {
+                                   std::lock_guard<std::mutex> lk(m);
+                                   if (!error)
+                                   {
+                                       error = std::current_exception();
+                                   }
+                               }
+
+                               // Notified under the lock: the group may be destroyed as soon as it is released
+                               std::lock_guard<std::mutex> lk(m);
+                               if (--pending == 0)
+                               {
+                                   all_done.notify_all();
+                               } });
+        }
+
+        /**
+         * @brief Waits for the tasks of the group, rethrowing the first exception thrown by one of them
+         */
+        void wait()
+        {
+            std::unique_lock<std::mutex> lk(m);
+            all_done.wait(lk, [&]
+                          { return pending == 0; });
+
+            if (error)
+            {
+                std::exception_ptr e = error;
+                error = nullptr;
+                std::rethrow_exception(e);
+            }
+        }
+    };
+}
+
+#endif
@@ -1,5 +1,10 @@
 
 #include "timer.hpp"
+#ifdef MEASURE_TSC
+#ifndef _MSC_VER
+#include <cpuid.h>
+#endif
+#endif
 
 namespace measure
 {
@@ -33,3 +38,59 @@ namespace measure
         return (_end - _start).count();
     }
 }
+
+namespace measure
+{
+    namespace
+    {
+        bool has_invariant_tsc()
+        {
+#ifdef MEASURE_TSC
+            unsigned int regs[4] = {0, 0, 0, 0};
+#ifdef _MSC_VER
+            __cpuid(reinterpret_cast<int *>(regs), 0x80000000);
+            if (regs[0] < 0x80000007)
+                return false;
+            __cpuid(reinterpret_cast<int *>(regs), 0x80000007);
+#else
+            if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007)
+                return false;
+            __get_cpuid(0x80000007, &regs[0], &regs[1], &regs[2], &regs[3]);
+#endif
+            return regs[3] & (1u << 8);
+#else
+            return false;
+#endif
+        }
+    }
+
+    const bool tsc_timer::invariant_tsc = has_invariant_tsc();
+
+    double tsc_timer::ns_per_tick()
+    {
+        static const double rate = []
+        {
+            using clock = std::chrono::steady_clock;
+
+            // The steady_clock ticks are already its period
+            if (!invariant_tsc)
+            {
+                return 1e9 * clock::period::num / clock::period::den;
+            }
+
+            // Busy wait of 10 ms, long enough for a rate within a few ppm
+            const auto start = clock::now();
+            const uint64_t start_ticks = ticks();
+            auto end = start;
+            while (end - start < std::chrono::milliseconds(10))
+            {
+                end = clock::now();
+            }
+            const uint64_t end_ticks = ticks();
+
+            return std::chrono::duration<double, std::nano>(end - start).count() / (end_ticks - start_ticks);
+        }();
+
+        return rate;
+    }
+}
@@ -4,19 +4,40 @@
 #include <cctype>
 #include <type_traits>
 
-template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
+namespace precise_la
+{
+    struct double_double;
+}
+
+/**
+ * @brief Whether T can be used as the data type of the estimators: the floating point types
+ * and precise_la::double_double
+ */
+template <typename T>
+struct is_real : std::is_floating_point<T>
+{
+};
+
+template <>
+struct is_real<precise_la::double_double> : std::true_type
+{
+};
+
+template <typename T, std::enable_if_t<true == is_real<T>(), bool> = true>
 const auto type_precision(){
     if constexpr (std::is_same_v<T, float>) return 9;
     else if constexpr (std::is_same_v<T, double>) return 17;
     else if constexpr (std::is_same_v<T, long double>) return 33;
+    else if constexpr (std::is_same_v<T, precise_la::double_double>) return 33;
     else return 9;
 }
 
-template <typename T, std::enable_if_t<true == std::is_floating_point<T>(), bool> = true>
+template <typename T, std::enable_if_t<true == is_real<T>(), bool> = true>
 const auto type_name() {
     if constexpr (std::is_same_v<T, float>) return "float";
     else if constexpr (std::is_same_v<T, double>) return "double";
     else if constexpr (std::is_same_v<T, long double>) return "long double";
+    else if constexpr (std::is_same_v<T, precise_la::double_double>) return "double-double";
     else return "";
 }
 